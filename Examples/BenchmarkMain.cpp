@@ -0,0 +1,344 @@
+/**
+ * \file BenchmarkMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Measures the scheduler on the target, for comparing builds before and after a change. \n
+ * Timer1 runs at the CPU clock as a cycle counter, so every result is in cycles. The results are left in m_Results, \n
+ * with done set once they're all in, for a debugger, or simavr with avr-gdb, to read. \n
+ * Build it with the same options as the application, then again at the commit before the change to get the numbers to compare against. \n
+ * To compare the context ports, build it with TASK_CONTEXT_ON_STACK at 0 and at 1. \n
+ * The RAM the scheduler keeps for every task, m_TaskControl and the per slot arrays beside it, is listed with sizes by avr-nm -S. \n
+ * Created using the Atmega1284, 12Mhz external crystal. Timer3 runs the scheduler, Timer1 is left to us. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+//------------------------------------------------------------------
+
+///How many times each measurement is taken, the smallest is kept so interrupts landing inside one don't count
+#define BENCH_SAMPLES							64
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+/**
+ * \brief Everything measured, in cycles of the CPU clock
+ */
+typedef struct BenchResults_t
+{
+	//Cycles of the scheduler interrupt, from the task being stopped to it running again, switching round robin back to the only runnable task
+	uint16_t isrRoundRobin;
+	
+	//Cycles of our own loop reading the counter, taken off isrRoundRobin
+	uint16_t counterLoop;
+	
+	//Cycles of TaskYieldNow, from one task calling it to the next one running
+	uint16_t yieldSwitch;
+	
+	//Bytes of each task control
+	uint16_t tcbBytes;
+	
+	//Bytes of a task status
+	uint8_t statusBytes;
+	
+	//Cycles of FindNextReadyTask with every slot attached, less reading the counter
+	uint16_t scanReady;
+	
+	//Cycles of FindNextHighestPriorityTask with every slot attached, less reading the counter
+	uint16_t scanHighest;
+	
+	//If the context is pushed on the task's stack instead of kept in its task control
+	bool contextOnStack;
+	
+	//Set once every result is in
+	bool done;
+	
+} BenchResults_t;
+
+///The results, for a debugger to read
+volatile BenchResults_t m_Results;
+
+///The counter when the ping task yielded
+static volatile uint16_t m_YieldStart;
+
+///Set once the scans are timed, letting the filler tasks end
+static volatile bool m_ScansDone;
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void CounterSetup(void);
+static void IsrSpinner(void);
+static void YieldPing(void);
+static void YieldPong(void);
+static void ScanTimer(void);
+static void ScanFiller(void);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* BenchmarkMain, main
+*/
+int main(void)
+{
+	//Start our cycle counter
+	CounterSetup();
+	
+	
+	//Time the scheduler interrupt with a single task, so every switch comes straight back to it
+	SetTaskSchedule(TASK_SCHEDULE_ROUND_ROBIN);
+	ScheduleTask(IsrSpinner);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	//Once finished, time a yield with two tasks handing over to each other
+	ScheduleTask(YieldPing);
+	ScheduleTask(YieldPong);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	//Once finished, time the scans with every slot filled, at priorities spread over the levels
+	ScheduleTask(ScanTimer);
+	
+	for(TaskIndiceType_t i = 1; i < MAX_TASKS; i++)
+	{
+		ScheduleTask(ScanFiller);
+		SetTaskPriority(i, i * 2);
+	}
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	//The sizes are known at compile time
+	m_Results.tcbBytes = sizeof(TaskControl_t);
+	m_Results.statusBytes = sizeof(TaskStatus_t);
+	m_Results.contextOnStack = TASK_CONTEXT_ON_STACK;
+	
+	//Everything is in
+	m_Results.done = true;
+	
+	//Loop forever, the results are read from here
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Runs Timer1 from the CPU clock with no prescaler, free running so it counts cycles
+*
+*/
+static void CounterSetup(void)
+{
+	//Normal mode, no compare outputs
+	TCCR1A = 0;
+	
+	//No prescaler
+	TCCR1B = (1 << CS10);
+	
+	//Start from 0
+	TCNT1 = 0;
+}
+
+
+
+/**
+* \brief Spins reading the counter. The smallest step is our own loop, and a step much bigger than it is the scheduler interrupt stopping us \n
+* and switching back to us, since we're all there is to run. The smallest of those, less our loop, is what the interrupt costs
+*/
+static void IsrSpinner(void)
+{
+	TASK_SECTION()
+	{
+		uint16_t last = TCNT1;
+		uint16_t loop = 0xffff;
+		uint16_t isr = 0xffff;
+		uint8_t samples = 0;
+		
+		//Take our loop's time first, it's the smallest step we see
+		for(uint8_t i = 0; i < BENCH_SAMPLES; i++)
+		{
+			const uint16_t now = TCNT1;
+			const uint16_t step = now - last;
+			last = now;
+			
+			if(step < loop)
+			{
+				loop = step;
+			}
+		}
+		
+		//Then wait out enough interrupts
+		while(samples < BENCH_SAMPLES)
+		{
+			const uint16_t now = TCNT1;
+			const uint16_t step = now - last;
+			last = now;
+			
+			//Anything past a few of our loops was the interrupt
+			if(step > loop * 4)
+			{
+				samples++;
+				
+				if(step < isr)
+				{
+					isr = step;
+				}
+			}
+		}
+		
+		m_Results.counterLoop = loop;
+		m_Results.isrRoundRobin = isr - loop;
+	}
+}
+
+
+
+/**
+* \brief Notes the counter and yields to the pong task, over and over
+*/
+static void YieldPing(void)
+{
+	TASK_SECTION()
+	{
+		for(uint8_t i = 0; i <= BENCH_SAMPLES; i++)
+		{
+			m_YieldStart = TCNT1;
+			TaskYieldNow();
+		}
+	}
+}
+
+
+
+/**
+* \brief Yields to the ping task and, once back, takes how long since it yielded. The smallest is the switch, less the few cycles reading the counter
+*/
+static void YieldPong(void)
+{
+	TASK_SECTION()
+	{
+		uint16_t best = 0xffff;
+		
+		for(uint8_t i = 0; i < BENCH_SAMPLES; i++)
+		{
+			TaskYieldNow();
+			
+			const uint16_t step = TCNT1 - m_YieldStart;
+			
+			if(step < best)
+			{
+				best = step;
+			}
+		}
+		
+		m_Results.yieldSwitch = best;
+	}
+}
+
+
+
+/**
+* \brief Times the scans the scheduler runs on every switch, with interrupts off so nothing lands inside. \n
+* Reading the counter twice with nothing between is taken off each
+*/
+static void ScanTimer(void)
+{
+	TASK_SECTION()
+	{
+		uint16_t counter = 0xffff;
+		uint16_t ready = 0xffff;
+		uint16_t highest = 0xffff;
+		
+		for(uint8_t i = 0; i < BENCH_SAMPLES; i++)
+		{
+			uint16_t start = 0;
+			uint16_t step = 0;
+			
+			//Reading the counter on its own
+			TASK_CRITICAL_SECTION (
+				start = TCNT1;
+				step = TCNT1 - start;
+			);
+			
+			if(step < counter)
+			{
+				counter = step;
+			}
+			
+			//The round robin scan, wrapping from the last slot
+			TASK_CRITICAL_SECTION (
+				start = TCNT1;
+				FindNextReadyTask(MAX_TASKS - 1);
+				step = TCNT1 - start;
+			);
+			
+			if(step < ready)
+			{
+				ready = step;
+			}
+			
+			//The highest priority scan
+			TASK_CRITICAL_SECTION (
+				start = TCNT1;
+				FindNextHighestPriorityTask();
+				step = TCNT1 - start;
+			);
+			
+			if(step < highest)
+			{
+				highest = step;
+			}
+		}
+		
+		m_Results.scanReady = ready - counter;
+		m_Results.scanHighest = highest - counter;
+		
+		//Let the fillers go
+		m_ScansDone = true;
+	}
+}
+
+
+
+/**
+* \brief Fills a slot for the scans to look over, handing straight back until they're done
+*/
+static void ScanFiller(void)
+{
+	TASK_SECTION()
+	{
+		while(!m_ScansDone)
+		{
+			TaskYieldNow();
+		}
+	}
+}
@@ -0,0 +1,205 @@
+/**
+ * \file EventGroupMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of tasks waiting on any or all of the bits of an event group, set from tasks and from an interrupt. \n
+ * PORTA:0 is a button to ground, with the internal pull up on, polled by a task \n
+ * PORTB:0 is a second button to ground, with the internal pull up on, caught by its pin change interrupt \n
+ * PORTD and PORTC:7 are connected to LED's with 300 ohm pull down resistors \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+//------------------------------------------------------------------
+
+///Set while the PORTA:0 button is held
+#define EVENT_BUTTON_A							(1 << 0)
+
+///Set by the PORTB:0 button's interrupt, on each press
+#define EVENT_BUTTON_B							(1 << 1)
+
+///Set once a second by the heartbeat task
+#define EVENT_HEARTBEAT							(1 << 2)
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///The events the tasks wait on
+static TaskEventGroup_t m_Events = TASK_EVENT_GROUP_INIT;
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void ButtonPoller(void);
+static void Heartbeat(void);
+static void BothButtons(void);
+static void AnyEvent(void);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* EventGroupMain, main
+*/
+int main(void)
+{
+	//Buttons as inputs with pull ups, LED's as outputs
+	DDRA = 0;
+	PORTA = (1 << 0);
+	DDRB = 0;
+	PORTB = (1 << 0);
+	DDRD = 0xff;
+	DDRC = 0xff;
+	
+	//Interrupt on any change of PORTB:0
+	PCMSK1 |= (1 << PCINT8);
+	PCICR |= (1 << PCIE1);
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Schedule our tasks, the waiters above the setters so they run as soon as they're woken
+	ScheduleTask(ButtonPoller);
+	ScheduleTask(Heartbeat);
+	ScheduleTask(BothButtons);
+	ScheduleTask(AnyEvent);
+	
+	SetTaskSchedule(TASK_SCHEDULE_PRIORITY);
+	
+	SetTaskPriority(2, 2);
+	SetTaskPriority(3, 2);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	
+	//Loop forever in case something goes wrong
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Sets EVENT_BUTTON_B on a press of the PORTB:0 button. Only the setting is done here, the waiters do the rest once we're out
+*/
+ISR(PCINT1_vect)
+{
+	if(!(PINB & (1 << 0)))
+	{
+		EventGroupSetFromISR(&m_Events, EVENT_BUTTON_B);
+	}
+}
+
+
+
+/**
+* \brief Task that forever polls the PORTA:0 button, keeping EVENT_BUTTON_A set while it's held
+*/
+static void ButtonPoller(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		if(!(PINA & (1 << 0)))
+		{
+			EventGroupSet(&m_Events, EVENT_BUTTON_A);
+		}
+		else
+		{
+			EventGroupClear(&m_Events, EVENT_BUTTON_A);
+		}
+		
+		TaskSetYield(tid, 20);
+	}
+}
+
+
+
+/**
+* \brief Task that forever sets EVENT_HEARTBEAT about once a second
+*/
+static void Heartbeat(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		TaskSetYield(tid, 1000);
+		EventGroupSet(&m_Events, EVENT_HEARTBEAT);
+	}
+}
+
+
+
+/**
+* \brief Task that forever waits for a press of B while A is held, toggling D:0 for each. Both are cleared as we're woken so each press counts once, \n
+* the poller sets A again while it's still held
+*/
+static void BothButtons(void)
+{
+	while(1)
+	{
+		EventGroupWait(&m_Events, EVENT_BUTTON_A | EVENT_BUTTON_B, TASK_EVENT_WAIT_ALL | TASK_EVENT_CLEAR_ON_EXIT, TASK_WAIT_FOREVER);
+		
+		PORTD ^= (1 << 0);
+	}
+}
+
+
+
+/**
+* \brief Task that forever waits for a press of B or a heartbeat, showing which on D:1 and D:2, and blinking C:7 if neither comes for two seconds. \n
+* Both are cleared as we're woken, after every waiter woken by the same set has seen them
+*/
+static void AnyEvent(void)
+{
+	while(1)
+	{
+		const TaskEventBits_t bits = EventGroupWait(&m_Events, EVENT_BUTTON_B | EVENT_HEARTBEAT, TASK_EVENT_CLEAR_ON_EXIT, 2000);
+		
+		//Nothing came in time
+		if(bits == 0)
+		{
+			PORTC ^= (1 << 7);
+			continue;
+		}
+		
+		if(bits & EVENT_BUTTON_B)
+		{
+			PORTD ^= (1 << 1);
+		}
+		
+		if(bits & EVENT_HEARTBEAT)
+		{
+			PORTD ^= (1 << 2);
+		}
+	}
+}
@@ -0,0 +1,143 @@
+/**
+ * \file JoinMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of a task starting workers, and joining on them for their exit values instead of polling until they're gone. \n
+ * PORTD and PORTC:7 are connected to LED's with 300 ohm pull down resistors \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+//------------------------------------------------------------------
+
+///The workers started each round, at IDs 1 and up
+#define WORKER_COUNT							3
+
+///The ticks the supervisor waits on each worker before giving up on it
+#define WORKER_TIMEOUT							2000
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///How many times each worker blinks before it exits. The last never finishes, to show a join timing out
+static uint8_t m_WorkerBlinks[WORKER_COUNT] = { 3, 6, 0xff };
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void Supervisor(void);
+static void Worker(uint8_t *blinks);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* JoinMain, main
+*/
+int main(void)
+{
+	//LED's as outputs
+	DDRD = 0xff;
+	DDRC = 0xff;
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Only the supervisor to start with, it starts the workers itself
+	AttachTask((void *)Supervisor, 0);
+	
+	SetTaskSchedule(TASK_SCHEDULE_ROUND_ROBIN);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	
+	//Loop forever in case something goes wrong
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Task that forever starts a round of workers, then joins on each in turn, sleeping until it exits. \n
+* Each exit value is shown on PORTD, and a worker that doesn't exit in time is killed, toggling C:7
+*/
+static void Supervisor(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		//Start the round, worker i at ID i + 1 with its blink count as its data
+		for(uint8_t i = 0; i < WORKER_COUNT; i++)
+		{
+			AttachTaskData((void *)Worker, i + 1, TASK_STACK_SIZE, &m_WorkerBlinks[i]);
+		}
+		
+		//Wait on each, in order
+		for(uint8_t i = 0; i < WORKER_COUNT; i++)
+		{
+			uint8_t exitValue = 0;
+			
+			if(TaskJoin(i + 1, WORKER_TIMEOUT, &exitValue))
+			{
+				PORTD = exitValue;
+			}
+			else
+			{
+				//KillTask joins on it too, so it's gone when this returns
+				KillTask(i + 1);
+				PORTC ^= (1 << 7);
+			}
+		}
+		
+		TaskSetYield(tid, 1000);
+	}
+}
+
+
+
+/**
+* \brief Worker task blinking D:7 the given times, then exiting with the count it blinked, which is handed to whoever joined on it
+* \param blinks How many times to blink
+*/
+static void Worker(uint8_t *blinks)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	for(uint8_t i = 0; i < *blinks; i++)
+	{
+		PORTD ^= (1 << 7);
+		TaskSetYield(tid, 150);
+	}
+	
+	//Doesn't return
+	TaskExit(*blinks);
+}
@@ -0,0 +1,216 @@
+/**
+ * \file QueueMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of passing messages between tasks with a queue, and whole buffers with a pool. \n
+ * PORTA is read as the input, with switches or jumpers to ground and the internal pull ups on \n
+ * PORTD shows each sample as it's received and PORTC:7 toggles for each buffer that comes through whole, on LED's with 300 ohm pull down resistors \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+//------------------------------------------------------------------
+
+///Samples the sample queue holds
+#define SAMPLE_QUEUE_LENGTH						8
+
+///Bytes in each frame
+#define FRAME_BYTES								16
+
+///Frames in the pool
+#define FRAME_COUNT								4
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///Queue of PORTA samples, copied in and out a byte at a time
+static TaskQueue_t m_SampleQueue;
+
+///Space for the samples
+static uint8_t m_SampleStorage[SAMPLE_QUEUE_LENGTH];
+
+///Pool of frames, so a whole frame can be handed over without copying it
+static TaskPool_t m_FramePool;
+
+///Space for the frames
+static uint8_t m_FrameStorage[FRAME_COUNT][FRAME_BYTES];
+
+///Queue handing the frames over, by pointer
+static TaskQueue_t m_FrameQueue;
+
+///Space for a pointer to every frame, so sending one never waits
+static void *m_FrameQueueStorage[FRAME_COUNT];
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void Sampler(void);
+static void SampleShower(void);
+static void Framer(void);
+static void FrameChecker(void);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* QueueMain, main
+*/
+int main(void)
+{
+	//PORTA as input with pull ups, the rest as outputs
+	DDRA = 0;
+	PORTA = 0xff;
+	DDRD = 0xff;
+	DDRC = 0xff;
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Set up the queues and the pool before anything can use them
+	QueueInit(&m_SampleQueue, m_SampleStorage, sizeof(uint8_t), SAMPLE_QUEUE_LENGTH);
+	PoolInit(&m_FramePool, m_FrameStorage, FRAME_BYTES, FRAME_COUNT);
+	QueueInit(&m_FrameQueue, m_FrameQueueStorage, sizeof(void *), FRAME_COUNT);
+	
+	
+	//Schedule our tasks, senders at 0 and 2, receivers at 1 and 3
+	ScheduleTask(Sampler);
+	ScheduleTask(SampleShower);
+	ScheduleTask(Framer);
+	ScheduleTask(FrameChecker);
+	
+	//Put the receivers above the senders, so each message is taken as soon as it's sent
+	SetTaskSchedule(TASK_SCHEDULE_PRIORITY);
+	
+	SetTaskPriority(1, 2);
+	SetTaskPriority(3, 2);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	
+	//Loop forever in case something goes wrong
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Task that forever samples PORTA and sends it to the sample queue, waiting while the queue is full
+*/
+static void Sampler(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		const uint8_t sample = PINA;
+		
+		QueueSend(&m_SampleQueue, &sample, TASK_WAIT_FOREVER);
+		TaskSetYield(tid, 100);
+	}
+}
+
+
+
+/**
+* \brief Task that forever shows each sample on PORTD as it's received, blinking D:7 if none come for a while
+*/
+static void SampleShower(void)
+{
+	uint8_t sample = 0;
+	
+	while(1)
+	{
+		if(QueueReceive(&m_SampleQueue, &sample, 500))
+		{
+			PORTD = sample;
+		}
+		else
+		{
+			PORTD ^= (1 << 7);
+		}
+	}
+}
+
+
+
+/**
+* \brief Task that forever fills a frame from the pool with a counting pattern and hands it over, waiting while every frame is in use
+*/
+static void Framer(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	uint8_t sequence = 0;
+	
+	while(1)
+	{
+		uint8_t *frame = (uint8_t *)PoolAlloc(&m_FramePool, TASK_WAIT_FOREVER);
+		
+		for(uint8_t i = 0; i < FRAME_BYTES; i++)
+		{
+			frame[i] = sequence + i;
+		}
+		
+		sequence++;
+		
+		//The frame is the checker's once sent
+		QueueSendBuffer(&m_FrameQueue, frame, TASK_WAIT_FOREVER);
+		TaskSetYield(tid, 250);
+	}
+}
+
+
+
+/**
+* \brief Task that forever takes each frame, toggles C:7 if its pattern came through whole, and frees it back to the pool
+*/
+static void FrameChecker(void)
+{
+	while(1)
+	{
+		uint8_t *frame = (uint8_t *)QueueReceiveBuffer(&m_FrameQueue, TASK_WAIT_FOREVER);
+		bool whole = true;
+		
+		for(uint8_t i = 1; i < FRAME_BYTES; i++)
+		{
+			if(frame[i] != (uint8_t)(frame[0] + i))
+			{
+				whole = false;
+			}
+		}
+		
+		if(whole)
+		{
+			PORTC ^= (1 << 7);
+		}
+		
+		PoolFree(&m_FramePool, frame);
+	}
+}
@@ -0,0 +1,168 @@
+/**
+ * \file SoftTimerMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of software timers, with their callbacks run by the timer daemon task. \n
+ * PORTA:0 and PORTA:1 are buttons to ground, with the internal pull ups on \n
+ * PORTD is connected to LED's with 300 ohm pull down resistors \n
+ * D:0 blinks from a reloading timer, A:1 changes how fast. A:0 turns D:7 on, and a one shot timer turns it off once A:0 is left alone for 3 seconds \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+//------------------------------------------------------------------
+
+///The slowest blink period, in ticks
+#define BLINK_SLOWEST							800
+
+///The fastest blink period, in ticks
+#define BLINK_FASTEST							100
+
+///How long D:7 stays on after the last press, in ticks
+#define LIGHT_ON_TICKS							3000
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///Reloading timer blinking D:0
+static TaskSoftTimer_t m_BlinkTimer;
+
+///One shot timer turning D:7 off
+static TaskSoftTimer_t m_LightTimer;
+
+///The pin each timer toggles or clears, passed to its callback
+static uint8_t m_BlinkPin = (1 << 0);
+static uint8_t m_LightPin = (1 << 7);
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void TogglePin(void *arg);
+static void ClearPin(void *arg);
+static void ButtonTask(void);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* SoftTimerMain, main
+*/
+int main(void)
+{
+	//Buttons as inputs with pull ups, LED's as outputs
+	DDRA = 0;
+	PORTA = (1 << 0) | (1 << 1);
+	DDRD = 0xff;
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Set up the timers before anything can start them
+	SoftTimerInit(&m_BlinkTimer, TogglePin, &m_BlinkPin, BLINK_SLOWEST, true);
+	SoftTimerInit(&m_LightTimer, ClearPin, &m_LightPin, LIGHT_ON_TICKS, false);
+	
+	//The daemon runs every callback, so it goes first at 0, above our buttons, with a stack for the deepest callback
+	AttachTimerDaemon(0, 2, TASK_STACK_SIZE);
+	ScheduleTask(ButtonTask);
+	
+	SetTaskSchedule(TASK_SCHEDULE_PRIORITY);
+	
+	//The blink runs from the start
+	SoftTimerStart(&m_BlinkTimer);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	
+	//Loop forever in case something goes wrong
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Timer callback toggling the pins of PORTD in arg. Runs in the timer daemon task, so it can do anything a task can, but holds up the other timers while it does
+* \param arg The pins to toggle
+*/
+static void TogglePin(void *arg)
+{
+	PORTD ^= *(uint8_t *)arg;
+}
+
+
+
+/**
+* \brief Timer callback clearing the pins of PORTD in arg
+* \param arg The pins to clear
+*/
+static void ClearPin(void *arg)
+{
+	PORTD &= ~*(uint8_t *)arg;
+}
+
+
+
+/**
+* \brief Task that forever polls the buttons. A:0 turns D:7 on and starts its timer over, A:1 halves the blink period until it wraps back to the slowest
+*/
+static void ButtonTask(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	TaskTimeout_t blinkPeriod = BLINK_SLOWEST;
+	bool blinkHeld = false;
+	
+	while(1)
+	{
+		//While held, keep the light on and its timer from running out
+		if(!(PINA & (1 << 0)))
+		{
+			PORTD |= m_LightPin;
+			SoftTimerStart(&m_LightTimer);
+		}
+		
+		//On each press, blink faster, starting over from the slowest
+		if(!(PINA & (1 << 1)))
+		{
+			if(!blinkHeld)
+			{
+				blinkPeriod = (blinkPeriod / 2 < BLINK_FASTEST) ? BLINK_SLOWEST : blinkPeriod / 2;
+				SoftTimerChangePeriod(&m_BlinkTimer, blinkPeriod);
+			}
+			
+			blinkHeld = true;
+		}
+		else
+		{
+			blinkHeld = false;
+		}
+		
+		TaskSetYield(tid, 20);
+	}
+}
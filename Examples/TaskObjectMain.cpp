@@ -0,0 +1,221 @@
+/**
+ * \file TaskObjectMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of the C++ task objects and scope guards from PreemptiveTaskScheduler.hpp. \n
+ * PORTA:0 is a button to ground, with the internal pull up on \n
+ * PORTD and PORTC:7 are connected to LED's with 300 ohm pull down resistors \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+#include "PreemptiveTaskScheduler.hpp"
+//------------------------------------------------------------------
+
+
+/**
+ * \brief A pin of PORTD to blink, and how fast. One blink function runs as a task for each
+ */
+struct BlinkPin
+{
+	//The pin
+	uint8_t mask;
+	
+	//Ticks between toggles
+	TaskTimeout_t ticks;
+};
+
+
+
+/**
+ * \brief Presses of the button, counted by one task and shown by another
+ */
+struct PressCounter
+{
+	//Presses so far
+	uint8_t presses;
+	
+	//If the button was down when last checked
+	bool down;
+};
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///Blinks C:7 at priority 1
+static TaskScheduler::Task<TASK_STACK_SIZE, 1> m_Heartbeat(0);
+
+///Blink D:0 and D:1 from the same function at different rates
+static TaskScheduler::Task<> m_FastBlinker(1);
+static TaskScheduler::Task<> m_SlowBlinker(2);
+
+///Counts the presses, bound to the counter at compile time so nothing is stored for it
+static TaskScheduler::Task<TASK_STACK_SIZE, 2> m_ButtonTask(3);
+
+///Shows the presses
+static TaskScheduler::Task<> m_ShowTask(4);
+
+///What each blinker blinks
+static BlinkPin m_FastPin = { (1 << 0), 100 };
+static BlinkPin m_SlowPin = { (1 << 1), 400 };
+
+///The count of presses. Before C++17, a bound argument can't be static
+PressCounter m_Presses = { 0, false };
+	
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void Heartbeat(void);
+static void BlinkWith(BlinkPin *pin);
+static void CountPresses(PressCounter &counter);
+static void ShowPresses(void);
+
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* TaskObjectMain, main
+*/
+int main(void)
+{
+	//Button as input with pull up, LED's as outputs
+	DDRA = 0;
+	PORTA = (1 << 0);
+	DDRD = 0xff;
+	DDRC = 0xff;
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Attach our tasks, each at its own ID with the stack and priority from its type
+	m_Heartbeat.Attach(Heartbeat);
+	m_FastBlinker.Attach(BlinkWith, &m_FastPin);
+	m_SlowBlinker.Attach(BlinkWith, &m_SlowPin);
+	m_ButtonTask.Attach<PressCounter, CountPresses, m_Presses>();
+	m_ShowTask.Attach(ShowPresses);
+	
+	SetTaskSchedule(TASK_SCHEDULE_PRIORITY);
+	
+	//Dispatch the tasks
+	DispatchTasks();
+	
+	
+	
+	//Loop forever in case something goes wrong
+	while(1)
+	{
+		
+	}
+	
+}
+
+
+
+/**
+* \brief Task that forever blinks C:7
+*/
+static void Heartbeat(void)
+{
+	while(1)
+	{
+		PORTC ^= (1 << 7);
+		TaskSetYield(m_Heartbeat.Id(), 1000);
+	}
+}
+
+
+
+/**
+* \brief Task that forever blinks the pin it's given. The read, toggle and write of PORTD is guarded, as every blinker shares it
+* \param pin The pin to blink and how fast
+*/
+static void BlinkWith(BlinkPin *pin)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		{
+			TaskScheduler::InterruptGuard guard;
+			
+			PORTD ^= pin->mask;
+		}
+		
+		TaskSetYield(tid, pin->ticks);
+	}
+}
+
+
+
+/**
+* \brief Task that forever counts presses of the button, stopping once it reaches 15 and killing the blinkers
+* \param counter The count, bound when attached
+*/
+static void CountPresses(PressCounter &counter)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(counter.presses < 15)
+	{
+		const bool down = !(PINA & (1 << 0));
+		
+		//Count on the way down
+		if(down && !counter.down)
+		{
+			counter.presses++;
+		}
+		
+		counter.down = down;
+		TaskSetYield(tid, 20);
+	}
+	
+	//Kill the blinkers, each returns once its task is gone
+	m_FastBlinker.Kill();
+	m_SlowBlinker.Kill();
+	
+	//Then ourselves
+	KillTask(tid);
+}
+
+
+
+/**
+* \brief Task that forever shows the presses on D:2 to D:5. The scheduler is held off while the bits are cleared and set, \n
+* so no other task runs between and sees them half written
+*/
+static void ShowPresses(void)
+{
+	while(1)
+	{
+		{
+			TaskScheduler::SchedulerLock lock;
+			
+			PORTD &= ~(0x0f << 2);
+			PORTD |= (m_Presses.presses & 0x0f) << 2;
+		}
+		
+		TaskSetYield(m_ShowTask.Id(), 50);
+	}
+}
@@ -0,0 +1,141 @@
+/**
+ * \file TaskTableMain.cpp
+ * \author Tim Robbins
+ * \date 10/16/2026
+ *
+ * \brief Example of declaring every task at compile time in a task table, with two periodic tasks given their priority by their period. \n
+ * PORTA is read as the input, with switches or jumpers to ground and the internal pull ups on \n
+ * PORTD and PORTC:7 are connected to LED's with 300 ohm pull down resistors \n
+ * Created using the Atmega1284, 12Mhz external crystal. \n
+ */ 
+
+///The frequency being used for the controller
+#define F_CPU                                       12000000UL
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+
+///The amount of max tasks we're allowed
+#define MAX_TASKS				11
+
+#define SCHEDULER_INT_VECTOR	TIMER3_OVF_vect
+
+#define TASK_INTERRUPT_TICKS	0x1f0
+
+#include "PreemptiveTaskScheduler.h"
+#include "PreemptiveTaskSchedulerTable.h"
+//------------------------------------------------------------------
+
+
+//Functions---------------------------------------------------------
+
+static void Blink(void);
+static void SampleInputs(void);
+static void ShowInputs(void);
+
+//------------------------------------------------------------------
+
+
+//Variables---------------------------------------------------------
+
+///Every task, X(func, stackSize, priority, period, wcet). The periodic ones are ordered by their period once started, so their priority is left at 0
+#define EXAMPLE_TASKS(X)					\
+	X(Blink, TASK_STACK_SIZE, 1, 0, 0)		\
+	X(SampleInputs, TASK_STACK_SIZE, 0, 20, 2)	\
+	X(ShowInputs, TASK_STACK_SIZE, 0, 100, 5)
+
+///The table, in flash, checked at compile time to fit
+TASK_TABLE_DEFINE(m_ExampleTasks, EXAMPLE_TASKS)
+
+///The last sample of PORTA
+static volatile uint8_t m_Inputs;
+	
+//------------------------------------------------------------------
+
+
+
+/**
+* \brief Drop in point. Change name and call in main if that's better
+* TaskTableMain, main
+*/
+int main(void)
+{
+	//PORTA as input with pull ups, the rest as outputs
+	DDRA = 0;
+	PORTA = 0xff;
+	DDRD = 0xff;
+	DDRC = 0xff;
+	
+	//Short delay, just in case (:
+	_delay_ms(10);
+	
+	
+	//Attach the whole table, entry i at slot i
+	AttachTaskTable(m_ExampleTasks, TASK_TABLE_COUNT(m_ExampleTasks));
+	
+	SetTaskSchedule(TASK_SCHEDULE_RATE_MONOTONIC);
+	
+	//Dispatch the tasks. If the periodic tasks can't all meet their deadlines, this returns straight away
+	DispatchTasks();
+	
+	
+	
+	//Loop forever, blinking everything if we couldn't start
+	while(1)
+	{
+		PORTD ^= 0xff;
+		_delay_ms(100);
+	}
+	
+}
+
+
+
+/**
+* \brief Task that forever blinks C:7, at a fixed priority below the periodic tasks
+*/
+static void Blink(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		PORTC ^= (1 << 7);
+		TaskSetYield(tid, 500);
+	}
+}
+
+
+
+/**
+* \brief Periodic task sampling PORTA every 20 ticks
+*/
+static void SampleInputs(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		m_Inputs = PINA;
+		TaskWaitNextPeriod(tid);
+	}
+}
+
+
+
+/**
+* \brief Periodic task showing the last sample on PORTD every 100 ticks, and D:7 once any deadline has been missed
+*/
+static void ShowInputs(void)
+{
+	TaskIndiceType_t tid = GetCurrentTaskID();
+	
+	while(1)
+	{
+		const bool missed = (GetTaskDeadlineMisses(1) > 0 || GetTaskDeadlineMisses(2) > 0);
+		
+		PORTD = (m_Inputs & 0x7f) | ((missed) ? (1 << 7) : 0);
+		TaskWaitNextPeriod(tid);
+	}
+}
@@ -5,28 +5,959 @@
  */
 #include "PreemptiveTaskScheduler.h"
 
+#include <stddef.h>
+
 #ifdef __AVR
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+#if TASK_IDLE_SLEEP
+#include <avr/sleep.h>
+#endif
+
 #endif
 
 
-///An array block of our task control structures
+///An array block of our task control structures. The fields the scheduler scans are kept out in the arrays below
 static TaskControl_t m_TaskControl[MAX_TASKS+1];
 
-///The index for our Task control block structure
+///The status of each control slot
+static volatile TaskStatus_t m_TaskStatus[MAX_TASKS+1];
+
+///The priority level of each control slot
+static TaskPriorityLevel_t m_TaskPriority[MAX_TASKS+1];
+
+///The count left for sleeping tasks in each control slot
+static TaskTimeout_t m_TaskTimeout[MAX_TASKS+1];
+
+///The index for our Task control block structure. Always the slot of the current task outside of switching
 static TaskIndiceType_t m_TaskBlockIndex;
 
+///The slot each task ID is in, -1 if nothing is attached with that ID
+static TaskIndiceType_t m_TaskSlot[MAX_TASKS+1] = { [0 ... MAX_TASKS] = -1 };
+
+///The slots of the tasks in the order the reorder schedule runs them, sorted by priority each time around
+static TaskIndiceType_t m_RunOrder[MAX_TASKS];
+
+///The position in the run order of the task last picked. MAX_TASKS is the main task, after which the order is sorted again
+static TaskIndiceType_t m_RunPosition;
+
+#if TASK_DEADLINES
+
+///The runnable task with the nearest absolute deadline, -1 if none. The rest follow through their deadline links in order
+static TaskIndiceType_t m_DeadlineHead = -1;
+
+///Bitmap of every task attached as a periodic task
+static TaskMask_t m_PeriodicMask;
+
+#endif
+
+#if TASK_STRIDE_SCHEDULING
+
+///The pass of the task last picked under stride scheduling. Tasks that become runnable start no earlier, so time spent waiting isn't banked
+static uint16_t m_StridePass;
+
+#endif
+
+///If the switch was asked for by a task through TaskYieldNow instead of the scheduler tick
+static volatile bool m_VoluntarySwitch;
+
+#if TASK_STACK_ARENA_SIZE > 0
+
+///The arena task stacks are carved from. Left out of startup clearing, and placed by the linker so it fails to link if RAM runs out
+static uint8_t m_StackArena[TASK_STACK_ARENA_SIZE] __attribute__ ((section (".noinit")));
+
+///The bytes of the arena carved out so far, from the bottom up with no gaps
+static uint16_t m_StackArenaUsed;
+
+#endif
+
 ///Count of the total items we've placed into the task control block
 static TaskIndiceType_t m_TaskBlockCount;
 
-///The current task context
-volatile TaskControl_t *m_CurrentTask;
+///The current task context
+volatile TaskControl_t *m_CurrentTask;
+
+///If the tasks have started running
+static bool m_blnTasksRunning;
+
+///The type of task schedule to use
+static TaskSchedule_t m_TaskSchedule;
+
+///Bitmap of every runnable task, one bit per control slot
+static TaskMask_t m_ReadyMask;
+
+///Runnable task bitmaps split by priority band
+static TaskMask_t m_ReadyBands[TASK_PRIORITY_BANDS];
+
+///Bitmap of the priority bands that have at least one runnable task
+static uint8_t m_ReadyBandMask;
+
+///The band each runnable task is filed under
+static uint8_t m_TaskBand[MAX_TASKS+1];
+
+///Bitmap of every task set as READY or MAIN, the only tasks TASK_SCHEDULE_PRIORITY_AND_READY picks from
+static TaskMask_t m_ReadyStatusMask;
+
+///Bitmap of every task that has not been killed or released
+static TaskMask_t m_LiveMask;
+
+///Bitmap of every task waiting to be killed by the scheduler
+static TaskMask_t m_KillMask;
+
+///The amount of slices the scheduler interrupt was loaded for
+static uint16_t m_TickSlices = 1;
+
+///Lowest set bit of a nibble
+static const uint8_t m_LowestBitTable[16] = {0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
+
+///Highest set bit of a nibble
+static const uint8_t m_HighestBitTable[16] = {0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3};
+
+
+
+/**
+* \brief Returns the index of the highest set bit in a byte. The byte must not be 0.
+* \param value The byte to check
+*/
+inline uint8_t _HighestSetBit8(uint8_t value)
+{
+	return (value & 0xf0) ? 4 + m_HighestBitTable[value >> 4] : m_HighestBitTable[value];
+}
+
+
+
+/**
+* \brief Returns the index of the lowest set bit in a task bitmap. The bitmap must not be 0.
+* \param mask The bitmap to check
+*/
+inline TaskIndiceType_t _LowestSetBit(TaskMask_t mask)
+{
+	uint8_t base = 0;
+	
+	#if MAX_TASKS >= 16
+		//If the low word is empty, move to the high word
+		if((uint16_t)mask == 0)
+		{
+			mask >>= 16;
+			base = 16;
+		}
+	#endif
+	
+	#if MAX_TASKS >= 8
+		//If the low byte is empty, move to the next byte
+		if((uint8_t)mask == 0)
+		{
+			mask >>= 8;
+			base += 8;
+		}
+	#endif
+	
+	//Look up the nibble holding our bit
+	return (mask & 0x0f) ? base + m_LowestBitTable[mask & 0x0f] : base + 4 + m_LowestBitTable[(uint8_t)mask >> 4];
+}
+
+
+
+/**
+* \brief Returns the first task in the bitmap that comes after the passed index, wrapping back to the start
+* \param mask The bitmap to search
+* \param after The index to search after, -1 to search from the start
+* \ret The found index, -1 if the bitmap is empty
+*/
+inline TaskIndiceType_t _NextSetBitAfter(TaskMask_t mask, TaskIndiceType_t after)
+{
+	TaskMask_t upper = 0;
+	
+	//If there's nothing to find, return out of range
+	if(mask == 0)
+	{
+		return -1;
+	}
+	
+	//Drop every bit at or below our index
+	if(after >= 0)
+	{
+		upper = mask & (TaskMask_t)~((TaskMask_t)((TaskMask_t)2 << after) - 1);
+	}
+	
+	//Use the upper bits if any, else wrap around
+	return _LowestSetBit(upper ? upper : mask);
+}
+
+
+
+/**
+* \brief Returns if the status is one the scheduler can switch to
+* \param status The status to check
+*/
+inline bool _IsRunnableStatus(TaskStatus_t status)
+{
+	return (status == TASK_READY || status == TASK_MAIN || status == TASK_SCHEDULED || status == TASK_SLEEP);
+}
+
+
+
+/**
+* \brief Returns the ready bitmap band for the passed priority
+* \param priority The priority level to band
+*/
+inline uint8_t _PriorityBand(TaskPriorityLevel_t priority)
+{
+	return (priority <= 0) ? 0 : ((priority >= TASK_PRIORITY_BANDS - 1) ? TASK_PRIORITY_BANDS - 1 : (uint8_t)priority);
+}
+
+
+
+/**
+* \brief Returns the whole slices that have passed in a stretched tickless interval, not yet counted in the scheduler ticks. Interrupts must be off.
+*
+*/
+uint16_t _TicklessElapsedSlices(void)
+{
+	#if TASK_TICKLESS_IDLE && TASK_TICKLESS_MAX_SLICES > 1
+	
+		//If we're stretched, count the slices the timer has run through so far
+		if(m_TickSlices > 1)
+		{
+			return ((m_TickSlices * TASK_INTERRUPT_TICKS) - _SCHEDULER_ISR_COUNTS_LEFT()) / TASK_INTERRUPT_TICKS;
+		}
+	
+	#endif
+	
+	return 0;
+}
+
+
+
+/**
+* \brief Ends a stretched tickless interval at the end of the slice we're in, so the scheduler looks at the tasks again. Interrupts must be off.
+*
+*/
+void _TicklessWake(void)
+{
+	#if TASK_TICKLESS_IDLE && TASK_TICKLESS_MAX_SLICES > 1
+	
+		uint16_t elapsed;
+		uint16_t slices;
+		
+		//If we're ticking every slice, nothing to do
+		if(m_TickSlices <= 1)
+		{
+			return;
+		}
+		
+		//Find how far into the stretched interval we are
+		elapsed = (m_TickSlices * TASK_INTERRUPT_TICKS) - _SCHEDULER_ISR_COUNTS_LEFT();
+		
+		//Fire at the end of the slice we're in, counting every slice that passed
+		slices = (elapsed / TASK_INTERRUPT_TICKS) + 1;
+		_SCHEDULER_LOAD_ISR_COUNTS((slices * TASK_INTERRUPT_TICKS) - elapsed);
+		m_TickSlices = slices;
+	
+	#endif
+}
+
+
+
+#if TASK_DEADLINES
+
+/**
+* \brief Links the task at the index into the deadline list if it has a deadline, keeping the list ordered by absolute deadline. Interrupts must be off.
+* \param index The task control index
+*/
+static inline void _DeadlineListInsert(TaskIndiceType_t index)
+{
+	TaskIndiceType_t *link = &m_DeadlineHead;
+	
+	//If we have no deadline, we're not listed. The main task never is
+	if(index >= MAX_TASKS || m_TaskControl[index].relativeDeadline <= 0)
+	{
+		return;
+	}
+	
+	//Walk past everyone due at or before us
+	while(*link >= 0 && (int32_t)(m_TaskControl[*link].absoluteDeadline - m_TaskControl[index].absoluteDeadline) <= 0)
+	{
+		link = &m_TaskControl[*link].deadlineNext;
+	}
+	
+	//Link in
+	m_TaskControl[index].deadlineNext = *link;
+	*link = index;
+}
+
+
+
+/**
+* \brief Unlinks the task at the index from the deadline list if it is in it. Interrupts must be off.
+* \param index The task control index
+*/
+static inline void _DeadlineListRemove(TaskIndiceType_t index)
+{
+	TaskIndiceType_t *link = &m_DeadlineHead;
+	
+	//Find the link pointing at us and unlink
+	while(*link >= 0)
+	{
+		if(*link == index)
+		{
+			*link = m_TaskControl[index].deadlineNext;
+			break;
+		}
+		
+		link = &m_TaskControl[*link].deadlineNext;
+	}
+}
+
+#endif
+
+
+
+/**
+* \brief Files the task at the index into the ready bitmaps. Interrupts must be off.
+* \param index The task control index
+*/
+static inline void _ReadyMapInsert(TaskIndiceType_t index)
+{
+	const TaskMask_t bit = (TaskMask_t)1 << index;
+	const uint8_t band = _PriorityBand(m_TaskPriority[index]);
+	
+	m_TaskBand[index] = band;
+	m_ReadyBands[band] |= bit;
+	m_ReadyBandMask |= (1 << band);
+	m_ReadyMask |= bit;
+	
+	#if TASK_STRIDE_SCHEDULING
+	
+		//Join stride scheduling no earlier than everyone else
+		if((int16_t)(m_TaskControl[index].pass - m_StridePass) < 0)
+		{
+			m_TaskControl[index].pass = m_StridePass;
+		}
+	
+	#endif
+	
+	#if TASK_DEADLINES
+	
+		_DeadlineListInsert(index);
+	
+	#endif
+}
+
+
+
+/**
+* \brief Removes the task at the index from the ready bitmaps. Interrupts must be off.
+* \param index The task control index
+*/
+static inline void _ReadyMapRemove(TaskIndiceType_t index)
+{
+	const TaskMask_t bit = (TaskMask_t)1 << index;
+	const uint8_t band = m_TaskBand[index];
+	
+	//If we're not filed, nothing to do
+	if((m_ReadyMask & bit) == 0)
+	{
+		return;
+	}
+	
+	m_ReadyBands[band] &= ~bit;
+	
+	//If our band is now empty, clear it
+	if(m_ReadyBands[band] == 0)
+	{
+		m_ReadyBandMask &= ~(1 << band);
+	}
+	
+	m_ReadyMask &= ~bit;
+	
+	#if TASK_DEADLINES
+	
+		_DeadlineListRemove(index);
+	
+	#endif
+}
+
+
+
+/**
+* \brief Returns if the schedule takes turns through the main task's slot, so the main task has to stay runnable
+* \param schedule The schedule
+*/
+static inline bool _ScheduleRunsMain(TaskSchedule_t schedule)
+{
+	return (schedule == TASK_SCHEDULE_PRIORITY_STRICT || schedule == TASK_SCHEDULE_PRIORITY_MAIN);
+}
+
+
+
+/**
+* \brief Writes the status of the task at the index and keeps the task bitmaps in step. Interrupts must be off.
+* \param index The task control index
+* \param status The new status
+*/
+void _WriteTaskStatus(TaskIndiceType_t index, TaskStatus_t status)
+{
+	const TaskMask_t bit = (TaskMask_t)1 << index;
+	
+	//Set the status
+	m_TaskStatus[index] = status;
+	
+	//If we can be switched to, make sure we're filed, else make sure we're not
+	if(_IsRunnableStatus(status))
+	{
+		if((m_ReadyMask & bit) == 0)
+		{
+			_ReadyMapInsert(index);
+			
+			//Someone new can run, so a stretched tickless interval has to end
+			_TicklessWake();
+		}
+	}
+	else
+	{
+		_ReadyMapRemove(index);
+	}
+	
+	//Track if we're set as READY or MAIN
+	if(status == TASK_READY || status == TASK_MAIN)
+	{
+		m_ReadyStatusMask |= bit;
+	}
+	else
+	{
+		m_ReadyStatusMask &= ~bit;
+	}
+	
+	//Track if we're alive
+	if(status != TASK_NONE && status != TASK_KILL)
+	{
+		m_LiveMask |= bit;
+	}
+	else
+	{
+		m_LiveMask &= ~bit;
+	}
+	
+	//Track if we're waiting to be killed
+	if(status == TASK_KILL)
+	{
+		m_KillMask |= bit;
+	}
+	else
+	{
+		m_KillMask &= ~bit;
+	}
+}
+
+
+
+/**
+* \brief Writes the priority of the task at the index and moves it between ready bands if needed. Interrupts must be off.
+* \param index The task control index
+* \param priority The new priority level
+*/
+void _WriteTaskPriority(TaskIndiceType_t index, TaskPriorityLevel_t priority)
+{
+	m_TaskPriority[index] = priority;
+	
+	//If we're filed under a different band now, refile
+	if((m_ReadyMask & ((TaskMask_t)1 << index)) && m_TaskBand[index] != _PriorityBand(priority))
+	{
+		_ReadyMapRemove(index);
+		_ReadyMapInsert(index);
+	}
+}
+
+
+
+/**
+* \brief Reads the priority of the task at the index
+* \param index The task control index
+* \ret The priority level
+*/
+TaskPriorityLevel_t _ReadTaskPriority(TaskIndiceType_t index)
+{
+	return m_TaskPriority[index];
+}
+
+
+
+/**
+* \brief Called by the scheduler when the timer of a task expires. Wakes the task and arms again for its default timeout. Interrupts must be off.
+* \param node The timer embedded in the task control
+*/
+static void _TaskTimerExpired(TaskTimerNode_t *node)
+{
+	//Get the task the timer belongs to
+	const TaskIndiceType_t index = (TaskControl_t *)((uint8_t *)node - offsetof(TaskControl_t, wakeTimer)) - m_TaskControl;
+	
+	//While a timed wait holds our timer, it only times out the wait. Any reload it held is put back by _TaskWaitWoken
+	if(m_TaskControl[index].waitState == TASK_WAIT_TIMED)
+	{
+		//If we timed out before being woken, stop waiting
+		if(m_TaskStatus[index] == TASK_BLOCKED)
+		{
+			m_TaskControl[index].waitState = TASK_WAIT_EXPIRED;
+			_TaskWake(index);
+		}
+		
+		return;
+	}
+	
+	//If our task is set to YIELD, set it back to ready
+	if(m_TaskStatus[index] == TASK_YIELD)
+	{
+		_WriteTaskStatus(index, TASK_READY);
+	}
+	
+	//If we have a default timeout, arm again from when we were due so the period does not drift
+	if(m_TaskControl[index].defaultTimeout > 0)
+	{
+		_TimerInsert(node, node->deadline + m_TaskControl[index].defaultTimeout);
+	}
+}
+
+
+
+/**
+* \brief Arms the timer of the task at the index to expire at the passed tick. Interrupts must be off.
+* \param index The task control index
+* \param deadline The scheduler tick to expire at
+*/
+void _TaskTimeoutArm(TaskIndiceType_t index, TaskTick_t deadline)
+{
+	m_TaskControl[index].wakeTimer.expired = _TaskTimerExpired;
+	_TimerInsert(&m_TaskControl[index].wakeTimer, deadline);
+}
+
+
+
+/**
+* \brief Disarms the timer of the task at the index if it is armed. Interrupts must be off.
+* \param index The task control index
+*/
+void _TaskTimeoutCancel(TaskIndiceType_t index)
+{
+	_TimerRemove(&m_TaskControl[index].wakeTimer);
+}
+
+
+
+/**
+* \brief Gives the task at the index a stack of at least the size. With an arena, a slot keeps its stack between tasks \n
+* and only carves a new one if it needs more. Interrupts must be off.
+* \param index The task control index
+* \param size The bytes the stack needs
+* \ret true if given, false if it doesn't fit
+*/
+static bool _TaskStackAssign(TaskIndiceType_t index, uint16_t size)
+{
+	TaskControl_t *task = &m_TaskControl[index];
+	
+	#if TASK_STACK_ARENA_SIZE > 0
+	
+		//If our stack doesn't cover the size...
+		if(task->stackBottom == 0 || task->stackSize < size)
+		{
+			//If ours is the last stack carved, it can grow in place
+			const bool last = (task->stackBottom != 0 && task->stackBottom + task->stackSize == m_StackArena + m_StackArenaUsed);
+			const uint16_t available = TASK_STACK_ARENA_SIZE - m_StackArenaUsed + ((last) ? task->stackSize : 0);
+			
+			//If there's not enough room left, we don't fit
+			if(size > available)
+			{
+				return false;
+			}
+			
+			//Carve right after the last stack
+			if(last)
+			{
+				m_StackArenaUsed -= task->stackSize;
+			}
+			
+			task->stackBottom = m_StackArena + m_StackArenaUsed;
+			task->stackSize = size;
+			m_StackArenaUsed += size;
+		}
+	
+	#else
+	
+		//Every slot has a fixed stack
+		if(size > TASK_STACK_SIZE)
+		{
+			return false;
+		}
+		
+		#ifdef RAMSTART
+		
+			//Check for allowances
+			if((TaskMemoryLocationType_t)_TASK_STACK_START_ADDRESS(index) - TASK_STACK_SIZE + 1 < RAMSTART)
+			{
+				return false;
+			}
+			
+		#endif
+		
+		task->stackBottom = (uint8_t *)_TASK_STACK_START_ADDRESS(index) - TASK_STACK_SIZE + 1;
+		task->stackSize = TASK_STACK_SIZE;
+	
+	#endif
+	
+	//Our stack grows down from the top
+	task->_taskStack = task->stackBottom + task->stackSize - 1;
+	
+	#if TASK_STACK_CHECK
+	
+		uint8_t *end = task->stackBottom + task->stackSize;
+		uint8_t *sp = SCHEDULER_ASM_STACK_POINTER();
+		
+		//Never paint over the stack we're running on, such as the startup stack under the fixed layout. Only the bytes under our stack pointer are free
+		if(sp < end)
+		{
+			end = (sp > task->stackBottom) ? sp : task->stackBottom;
+		}
+		
+		//Paint so we can see how far the stack has been used
+		for(uint8_t *byte = task->stackBottom; byte < end; byte++)
+		{
+			*byte = TASK_STACK_PAINT;
+		}
+	
+	#endif
+	
+	return true;
+}
+
+
+
+/**
+* \brief Sets up the context of the task at the index to start running the function from the top of its stack, with its task data \n
+* in r24 and r25 as the function's first argument. With TASK_CONTEXT_ON_STACK, a cleared context is pushed on its stack under \n
+* the function's address, as if switched out. Interrupts must be off.
+* \param index The task control index
+* \param func The function to start at
+*/
+static void _TaskContextInit(TaskIndiceType_t index, void *func)
+{
+	//We start from a whole context
+	m_TaskControl[index].contextPartial = false;
+	
+	//Our data goes where a function's first pointer argument is passed
+	const TaskMemoryLocationType_t arg = (TaskMemoryLocationType_t)m_TaskControl[index].taskData;
+	
+	#if TASK_CONTEXT_ON_STACK
+	
+		uint8_t *sp = (uint8_t *)m_TaskControl[index]._taskStack;
+		
+		//The return address first, low byte on top the way a call or interrupt leaves it
+		*sp-- = (uint8_t)((TaskMemoryLocationType_t)func);
+		*sp-- = (uint8_t)((TaskMemoryLocationType_t)func >> 8);
+		
+		//Then r0, SREG, and r1 to r31, all cleared but the argument. Register n is the n+1th byte
+		for(uint8_t i = 0; i < TASK_REGISTERS + 1; i++)
+		{
+			*sp-- = (i == 24 + 1) ? (uint8_t)arg : (i == 25 + 1) ? (uint8_t)(arg >> 8) : 0;
+		}
+		
+		m_TaskControl[index].taskExecutionContext.sp.ptr = sp;
+	
+	#else
+	
+		//initialize stack pointer and program counter for our program execution
+		m_TaskControl[index].taskExecutionContext.sp.ptr = ((uint8_t *)m_TaskControl[index]._taskStack);
+		m_TaskControl[index].taskExecutionContext.pc.ptr = func;
+		m_TaskControl[index].taskExecutionContext.registerFile[24] = (uint8_t)arg;
+		m_TaskControl[index].taskExecutionContext.registerFile[25] = (uint8_t)(arg >> 8);
+	
+	#endif
+}
+
+
+
+/**
+* \brief Returns the most bytes of its stack the task with the passed ID has used, found by how much of the paint is left. \n
+* Without TASK_STACK_CHECK the stacks aren't painted, so it can't be known and 0 is returned, the same as for a task that isn't attached
+* \param id The task ID
+* \ret The bytes used, 0 if unknown
+*/
+uint16_t GetTaskStackHighWater(TaskIndiceType_t id)
+{
+	#if TASK_STACK_CHECK
+	
+		uint8_t *bottom = 0;
+		uint16_t size = 0;
+		uint16_t untouched = 0;
+		
+		TASK_CRITICAL_SECTION (
+		
+			//Get the slot for our ID
+			const TaskIndiceType_t index = _GetTaskIndex(id);
+			
+			if(index >= 0)
+			{
+				bottom = m_TaskControl[index].stackBottom;
+				size = m_TaskControl[index].stackSize;
+			}
+		);
+		
+		//Count the paint left from the bottom up, the stack never reached there
+		while(bottom != 0 && untouched < size && bottom[untouched] == TASK_STACK_PAINT)
+		{
+			untouched++;
+		}
+		
+		return size - untouched;
+	
+	#else
+	
+		//Nothing was painted to measure against
+		return 0;
+	
+	#endif
+}
+
+
+
+/**
+* \brief Called from the scheduler when the task being switched out has run past its stack. Interrupts are off. \n
+* By default kills the task, leaving the main task running. Define your own to do anything else, such as logging or a reset
+* \param id The task ID
+*/
+__attribute__ ((weak)) void TaskStackOverflow(TaskIndiceType_t id)
+{
+	const TaskIndiceType_t index = _GetTaskIndex(id);
+	
+	//Have the scheduler kill us before anyone runs again
+	if(index >= 0 && index < MAX_TASKS)
+	{
+		_WriteTaskStatus(index, TASK_KILL);
+	}
+}
+
+
+
+/**
+* \brief Returns the task control at the index, for the sharing objects
+* \param index The task control index
+*/
+TaskControl_t* _GetTaskControl(TaskIndiceType_t index)
+{
+	return &m_TaskControl[index];
+}
+
+
+
+/**
+* \brief Links the task at the index into the wait list, behind everyone of the same or a higher priority. Interrupts must be off.
+* \param head The head of the wait list
+* \param index The task control index
+*/
+void _WaitListInsert(TaskIndiceType_t *head, TaskIndiceType_t index)
+{
+	TaskIndiceType_t *link = head;
+	
+	//Walk past everyone at or above our priority so equal priorities wait their turn
+	while(*link >= 0 && m_TaskPriority[*link] >= m_TaskPriority[index])
+	{
+		link = &m_TaskControl[*link].waitNext;
+	}
+	
+	//Link in
+	m_TaskControl[index].waitNext = *link;
+	m_TaskControl[index].waitList = head;
+	*link = index;
+}
+
+
+
+/**
+* \brief Unlinks the task at the index from the wait list it is in, if any. Interrupts must be off.
+* \param index The task control index
+*/
+void _WaitListRemove(TaskIndiceType_t index)
+{
+	TaskIndiceType_t *link = m_TaskControl[index].waitList;
+	
+	//If we're not waiting, nothing to do
+	if(link == 0)
+	{
+		return;
+	}
+	
+	//Find the link pointing at us and unlink
+	while(*link >= 0)
+	{
+		if(*link == index)
+		{
+			*link = m_TaskControl[index].waitNext;
+			break;
+		}
+		
+		link = &m_TaskControl[*link].waitNext;
+	}
+	
+	m_TaskControl[index].waitList = 0;
+}
+
+
+
+/**
+* \brief Takes the first task off the wait list. Interrupts must be off.
+* \param head The head of the wait list
+* \ret The task control index, -1 if nobody was waiting
+*/
+TaskIndiceType_t _WaitListPop(TaskIndiceType_t *head)
+{
+	const TaskIndiceType_t index = *head;
+	
+	if(index >= 0)
+	{
+		*head = m_TaskControl[index].waitNext;
+		m_TaskControl[index].waitList = 0;
+	}
+	
+	return index;
+}
+
+
+
+/**
+* \brief Links the task at the index onto the end of the wait list. Interrupts must be off.
+* \param head The head of the wait list
+* \param index The task control index
+*/
+void _WaitListAppend(TaskIndiceType_t *head, TaskIndiceType_t index)
+{
+	TaskIndiceType_t *link = head;
+	
+	//Walk to the end
+	while(*link >= 0)
+	{
+		link = &m_TaskControl[*link].waitNext;
+	}
+	
+	//Link in
+	m_TaskControl[index].waitNext = -1;
+	m_TaskControl[index].waitList = head;
+	*link = index;
+}
+
+
+
+/**
+* \brief Blocks the task at the index in the wait list until it is woken. Interrupts must be off.
+* \param index The task control index
+* \param head The head of the wait list
+*/
+void _TaskBlock(TaskIndiceType_t index, TaskIndiceType_t *head)
+{
+	_WaitListInsert(head, index);
+	_WriteTaskStatus(index, TASK_BLOCKED);
+}
+
+
+
+/**
+* \brief Blocks the task at the index in the wait list until it is woken or the timeout runs out. Interrupts must be off.
+* \param index The task control index
+* \param head The head of the wait list
+* \param order The order the wait list is woken in
+* \param timeout The ticks to wait at most, TASK_WAIT_FOREVER to wait until woken
+*/
+void _TaskBlockFor(TaskIndiceType_t index, TaskIndiceType_t *head, TaskWaitOrder_t order, TaskTimeout_t timeout)
+{
+	if(order == TASK_WAIT_FIFO)
+	{
+		_WaitListAppend(head, index);
+	}
+	else
+	{
+		_WaitListInsert(head, index);
+	}
+	
+	_WriteTaskStatus(index, TASK_BLOCKED);
+	
+	//If we only wait so long, our timer wakes us
+	if(timeout > 0)
+	{
+		//If our timer is armed for a default timeout reload, hold its deadline so it can be put back once we're done waiting
+		m_TaskControl[index].reloadHeld = (m_TaskControl[index].defaultTimeout > 0 && _TimerIsArmed(&m_TaskControl[index].wakeTimer));
+		m_TaskControl[index].reloadDeadline = m_TaskControl[index].wakeTimer.deadline;
+		
+		m_TaskControl[index].waitState = TASK_WAIT_TIMED;
+		_TaskTimeoutArm(index, _TimerTicks() + timeout);
+	}
+	else
+	{
+		m_TaskControl[index].waitState = TASK_WAIT_UNTIMED;
+	}
+}
+
+
+
+/**
+* \brief Gives up the processor until the task at the index, blocked by _TaskBlockFor, is woken. Call with interrupts on.
+* \param index The task control index
+* \ret true if woken, false if the timeout ran out first
+*/
+bool _TaskWaitWoken(TaskIndiceType_t index)
+{
+	bool woken;
+	
+	//Let everyone else run while we're blocked
+	while(m_TaskStatus[index] == TASK_BLOCKED)
+	{
+		TaskYieldNow();
+	}
+	
+	TASK_CRITICAL_SECTION (
+	
+		//If our wait had a timeout, our timer is done with it
+		if(m_TaskControl[index].waitState != TASK_WAIT_UNTIMED)
+		{
+			_TaskTimeoutCancel(index);
+			
+			//Put back the reload our wait held, on the first of its ticks still to come so the period does not drift
+			if(m_TaskControl[index].reloadHeld)
+			{
+				TaskTick_t deadline = m_TaskControl[index].reloadDeadline;
+				const TaskTick_t late = _TimerTicks() - deadline;
+				
+				if((int32_t)late >= 0)
+				{
+					deadline += ((late / m_TaskControl[index].defaultTimeout) + 1) * m_TaskControl[index].defaultTimeout;
+				}
+				
+				m_TaskControl[index].reloadHeld = false;
+				_TaskTimeoutArm(index, deadline);
+			}
+		}
+		
+		woken = (m_TaskControl[index].waitState != TASK_WAIT_EXPIRED);
+		m_TaskControl[index].waitState = TASK_WAIT_UNTIMED;
+	);
+	
+	return woken;
+}
+
 
-///If the tasks have started running
-static bool m_blnTasksRunning;
 
-///The type of task schedule to use
-static TaskSchedule_t m_TaskSchedule;
+/**
+* \brief Wakes the blocked task at the index, taking it out of its wait list if it is still in one. Interrupts must be off.
+* \param index The task control index
+*/
+void _TaskWake(TaskIndiceType_t index)
+{
+	_WaitListRemove(index);
+	
+	//Only blocked tasks are woken, the main task goes back to being main
+	if(m_TaskStatus[index] == TASK_BLOCKED)
+	{
+		_WriteTaskStatus(index, (index == MAX_TASKS) ? TASK_MAIN : TASK_READY);
+	}
+}
 
 
 
@@ -69,14 +1000,18 @@ inline TaskControl_t* GetTask(void *task_func)
 */
 inline void SetTaskDefaultTimeout(TaskIndiceType_t id, TaskTimeout_t timeout)
 {
-	//If our ID is within range...
-	if(id >= 0 && id <= MAX_TASKS)
-	{
-		TASK_CRITICAL_SECTION (
-			//Set our priority
-			m_TaskControl[id].defaultTimeout = timeout;
-		);
-	}
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached...
+		if(index >= 0)
+		{
+			//Set our default timeout
+			m_TaskControl[index].defaultTimeout = timeout;
+		}
+	);
 }
 
 
@@ -88,56 +1023,261 @@ inline void SetTaskDefaultTimeout(TaskIndiceType_t id, TaskTimeout_t timeout)
 */
 inline void SetTaskPriority(TaskIndiceType_t id, TaskPriorityLevel_t priority)
 {
-	//If our ID is within range...
-	if(id >= 0 && id < MAX_TASKS)
-	{
-		TASK_CRITICAL_SECTION (
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached and not the main task...
+		if(index >= 0 && index < MAX_TASKS)
+		{
 			//Set our priority
-			m_TaskControl[id].priority = priority;
-			m_TaskControl[id].cachedPriority = priority;
-		);
+			_WriteTaskPriority(index, priority);
+			m_TaskControl[index].cachedPriority = priority;
+		}
+	);
+}
+
+
+
+#if TASK_STRIDE_SCHEDULING
+
+/**
+* \brief Sets the weight of the task with the passed ID under stride scheduling. A task gets the processor in proportion to its weight
+* \param id The id of the task
+* \param weight The weight of the task, 1 to 255. 0 is taken as 1
+*/
+void SetTaskWeight(TaskIndiceType_t id, uint8_t weight)
+{
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached...
+		if(index >= 0)
+		{
+			//Set our stride
+			m_TaskControl[index].stride = TASK_STRIDE_ONE / ((weight > 0) ? weight : 1);
+		}
+	);
+}
+
+#endif
+
+
+
+#if TASK_DEADLINES
+
+/**
+* \brief Releases a job of the task at the index at the current tick, moving it in the deadline list to its new deadline. Interrupts must be off.
+* \param index The task control index
+*/
+static void _ReleaseTaskNow(TaskIndiceType_t index)
+{
+	//Take us out of the deadline list while our deadline changes
+	_DeadlineListRemove(index);
+	
+	m_TaskControl[index].release = _TimerTicks();
+	m_TaskControl[index].absoluteDeadline = m_TaskControl[index].release + m_TaskControl[index].relativeDeadline;
+	
+	//If we're runnable, file us again
+	if(m_ReadyMask & ((TaskMask_t)1 << index))
+	{
+		_DeadlineListInsert(index);
 	}
 }
 
 
 
 /**
-* \brief Gets the ID at the passed task index
-* \param index The index to fetch the ID at
+* \brief Gives every periodic task a priority by its period, shortest first, from the highest band down. Interrupts must be off.
+*
 */
-const TaskIndiceType_t _GetTaskID(TaskIndiceType_t index)
+void _AssignRateMonotonicPriorities(void)
 {
-	//If our index is within range, return our id, else return out of range
-	return (index >= 0 && index <= MAX_TASKS) ? m_TaskControl[index].taskID : -1;	
+	//For each periodic task...
+	for(TaskIndiceType_t i = 0; i < MAX_TASKS; i++)
+	{
+		if(m_PeriodicMask & ((TaskMask_t)1 << i))
+		{
+			TaskPriorityLevel_t rank = 0;
+			
+			//Count the distinct shorter periods
+			for(TaskIndiceType_t j = 0; j < MAX_TASKS; j++)
+			{
+				if((m_PeriodicMask & ((TaskMask_t)1 << j)) && m_TaskControl[j].period < m_TaskControl[i].period)
+				{
+					bool counted = false;
+					
+					//Only count each period once, so equal periods share a priority
+					for(TaskIndiceType_t k = 0; k < j; k++)
+					{
+						if((m_PeriodicMask & ((TaskMask_t)1 << k)) && m_TaskControl[k].period == m_TaskControl[j].period)
+						{
+							counted = true;
+							break;
+						}
+					}
+					
+					if(!counted)
+					{
+						rank++;
+					}
+				}
+			}
+			
+			//Shorter periods go higher. Past the bottom band everyone shares it
+			rank = (TASK_PRIORITY_BANDS - 1) - rank;
+			_WriteTaskPriority(i, (rank > 0) ? rank : 0);
+			m_TaskControl[i].cachedPriority = m_TaskPriority[i];
+		}
+	}
 }
 
 
 
 /**
-* \brief Gets the FIRST index for the passed task ID
-* \param index The index to fetch the ID at
+* \brief Checks if every periodic task can meet its deadline. Uses the utilization bound under TASK_SCHEDULE_EDF, else response time analysis with tasks in the same or higher priority band counted as interference
+* \ret true if every periodic task meets its deadline
 */
-TaskIndiceType_t _GetTaskIndex(TaskIndiceType_t id)
+bool ArePeriodicTasksSchedulable()
 {
-	//Create an index value, initialized to out of range
-	TaskIndiceType_t index = -1;
+	uint32_t density = 0;
 	
-	//While we're within range of our tasks...
-	for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
+	//For each periodic task...
+	for(TaskIndiceType_t i = 0; i < MAX_TASKS; i++)
 	{
-		//If we've found our ID...
-		if(m_TaskControl[i].taskID == id)
+		if((m_PeriodicMask & ((TaskMask_t)1 << i)) == 0)
+		{
+			continue;
+		}
+		
+		const uint32_t deadline = (m_TaskControl[i].relativeDeadline > 0) ? m_TaskControl[i].relativeDeadline : m_TaskControl[i].period;
+		
+		//Under EDF, add up how much of the processor we need against our deadline, in 1/65536ths rounded up
+		if(m_TaskSchedule == TASK_SCHEDULE_EDF)
+		{
+			density += (((uint32_t)m_TaskControl[i].wcet << 16) + deadline - 1) / deadline;
+			continue;
+		}
+		
+		uint32_t response = m_TaskControl[i].wcet;
+		uint32_t last = 0;
+		
+		//Until our response time stops growing...
+		while(response != last)
 		{
-			//Set our return value
-			index = i;
+			last = response;
+			response = m_TaskControl[i].wcet;
 			
-			//Break
-			break;
+			//Add every job of every task that can run ahead of us in that time
+			for(TaskIndiceType_t j = 0; j < MAX_TASKS; j++)
+			{
+				if(j != i && (m_PeriodicMask & ((TaskMask_t)1 << j)) && _PriorityBand(m_TaskPriority[j]) >= _PriorityBand(m_TaskPriority[i]))
+				{
+					response += ((last + TASK_RELEASE_JITTER_TICKS + m_TaskControl[j].period - 1) / m_TaskControl[j].period) * m_TaskControl[j].wcet;
+				}
+			}
+			
+			//If we can't make our deadline, the set can't run
+			if(response + TASK_RELEASE_JITTER_TICKS > deadline)
+			{
+				return false;
+			}
 		}
 	}
 	
-	return index;
+	return density <= ((uint32_t)1 << 16);
+}
+
+
+
+/**
+* \brief Sets the period and relative deadline of the task with the passed ID, releasing its first job now
+* \param id The id of the task
+* \param period The ticks between releases, 0 for a single job
+* \param relativeDeadline The ticks after each release the job is due by, 0 to clear the deadline
+*/
+void SetTaskDeadline(TaskIndiceType_t id, TaskTimeout_t period, TaskTimeout_t relativeDeadline)
+{
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached and not the main task...
+		if(index >= 0 && index < MAX_TASKS)
+		{
+			//Set our deadline and release now
+			m_TaskControl[index].period = period;
+			m_TaskControl[index].relativeDeadline = relativeDeadline;
+			_ReleaseTaskNow(index);
+		}
+	);
+}
+
+
+
+/**
+* \brief Returns the amount of jobs of the task with the passed ID that finished after their deadline
+* \param id The id of the task
+*/
+uint16_t GetTaskDeadlineMisses(TaskIndiceType_t id)
+{
+	uint16_t misses = 0;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached, get our count
+		if(index >= 0)
+		{
+			misses = m_TaskControl[index].deadlineMisses;
+		}
+	);
 	
+	return misses;
+}
+
+#endif
+
+
+
+/**
+* \brief Gets the ID at the passed task index
+* \param index The index to fetch the ID at
+*/
+const TaskIndiceType_t _GetTaskID(TaskIndiceType_t index)
+{
+	//If our index is within range, return our id, else return out of range
+	return (index >= 0 && index <= MAX_TASKS) ? m_TaskControl[index].taskID : -1;	
+}
+
+
+
+/**
+* \brief Gets the index for the passed task ID from the ID to slot map
+* \param id The ID to fetch the index for
+* \ret The index of the task, -1 if nothing is attached with the ID
+*/
+TaskIndiceType_t _GetTaskIndex(TaskIndiceType_t id)
+{
+	//If our ID is within range, return its slot, else return out of range
+	return (id >= 0 && id <= MAX_TASKS) ? m_TaskSlot[id] : -1;
+}
+
+
+
+/**
+* \brief Gets the index of the task calling, for the waits that block it
+* \ret The index of the current task, -1 before the tasks are started since there is no task to block yet
+*/
+TaskIndiceType_t _GetCurrentTaskIndex()
+{
+	return (m_blnTasksRunning && m_CurrentTask != 0) ? _GetTaskIndex(m_CurrentTask->taskID) : -1;
 }
 
 
@@ -149,8 +1289,36 @@ TaskIndiceType_t _GetTaskIndex(TaskIndiceType_t id)
 */
 inline TaskStatus_t GetTaskStatus(TaskIndiceType_t id)
 {
-	//If our ID is within range, return our status, else return none
-	return (id >= 0 && id <= MAX_TASKS) ? m_TaskControl[id].taskStatus : TASK_NONE;	
+	//Get the slot for our ID
+	const TaskIndiceType_t index = _GetTaskIndex(id);
+	
+	//If our ID is attached, return our status, else return none
+	return (index >= 0) ? m_TaskStatus[index] : TASK_NONE;	
+}
+
+
+
+/**
+* \brief Returns the data of the specified task, the argument its function was called with
+* \param id The task id to check at
+* \ret The task data, 0 if none or not attached
+*/
+void *GetTaskData(TaskIndiceType_t id)
+{
+	void *data = 0;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		if(index >= 0)
+		{
+			data = m_TaskControl[index].taskData;
+		}
+	);
+	
+	return data;
 }
 
 
@@ -162,14 +1330,18 @@ inline TaskStatus_t GetTaskStatus(TaskIndiceType_t id)
 */
 inline void SetTaskStatus(TaskIndiceType_t id, TaskStatus_t status)
 {
-	//If our ID is within range...
-	if(id >= 0 && id < MAX_TASKS)
-	{
-		TASK_CRITICAL_SECTION (
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for our ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		
+		//If our ID is attached and not the main task...
+		if(index >= 0 && index < MAX_TASKS)
+		{
 			//Set our status
-			m_TaskControl[id].taskStatus = status;
-		);
-	}
+			_WriteTaskStatus(index, status);
+		}
+	);
 	 
 }
 
@@ -184,55 +1356,97 @@ void StartTasks(void *mainfunc, TaskPriorityLevel_t taskPriority)
 	//If we have tasks to launch...
 	if(m_TaskBlockCount > 0)
 	{
+		#if TASK_DEADLINES
+		
+			//Give periodic tasks their rate monotonic priorities
+			TASK_CRITICAL_SECTION ( _AssignRateMonotonicPriorities(); );
+			
+			//If our periodic tasks can't all meet their deadlines, don't start
+			if(!ArePeriodicTasksSchedulable())
+			{
+				return;
+			}
+		
+		#endif
+		
 		//Disable Global interrupts and execute code
 		TASK_CRITICAL_SECTION (
 	
-			//Set our task index to the start
-			m_TaskBlockIndex = 0;
-	
 			//For each task...
 			for(TaskIndiceType_t i = 0; i < MAX_TASKS; i++)
 			{
+				//Start the run order in slot order
+				m_RunOrder[i] = i;
+				
 				//If we're within range for our count to set to ready and we meet all settings...
-				if(i < m_TaskBlockCount && m_TaskControl[i].taskStatus != TASK_NONE)
+				if(i < m_TaskBlockCount && m_TaskStatus[i] != TASK_NONE)
 				{
 					//Set to ready
-					m_TaskControl[i].taskStatus = TASK_READY;
+					_WriteTaskStatus(i, TASK_READY);
+					
+					#if TASK_DEADLINES
+					
+						//Release every periodic task together
+						if(m_PeriodicMask & ((TaskMask_t)1 << i))
+						{
+							_ReleaseTaskNow(i);
+						}
+					
+					#endif
 				}
 				//else...
 				else
 				{
 					//Set to blocked
-					m_TaskControl[i].taskStatus = TASK_NONE;
-					m_TaskControl[i].priority = -1;
+					m_TaskPriority[i] = -1;
+					_WriteTaskStatus(i, TASK_NONE);
 				}
 			
 				//Make sure priorities are set appropriatly
-				m_TaskControl[i].cachedPriority = m_TaskControl[i].priority;
+				m_TaskControl[i].cachedPriority = m_TaskPriority[i];
 			}
 	
 			//Make sure we attach our ending task
 			//Make sure last task is set, is reserved. Set its ID as well
-			m_TaskControl[MAX_TASKS].taskStatus = TASK_MAIN;
 			m_TaskControl[MAX_TASKS].taskID = MAX_TASKS;
-			m_TaskControl[MAX_TASKS]._taskStack = _TASK_STACK_START_ADDRESS(MAX_TASKS);
+			m_TaskSlot[MAX_TASKS] = MAX_TASKS;
 	
 			//Set the function
 			m_TaskControl[MAX_TASKS].task_func = mainfunc;
 	
 			//Set our default timeout
-			m_TaskControl[MAX_TASKS].timeout = 0;
+			m_TaskTimeout[MAX_TASKS] = 0;
 			m_TaskControl[MAX_TASKS].defaultTimeout = 0;
+			m_TaskControl[MAX_TASKS].reloadHeld = false;
+			_TaskTimeoutCancel(MAX_TASKS);
+			
+			//Start one slice at a time
+			m_TickSlices = 1;
 	
-			//initialize stack pointer and program counter for our program execution
-			m_TaskControl[MAX_TASKS].taskExecutionContext.sp.ptr = ((uint8_t *)m_TaskControl[MAX_TASKS]._taskStack);
-			m_TaskControl[MAX_TASKS].taskExecutionContext.pc.ptr = mainfunc;
+			//The main task is us, on the startup stack. Our context is saved into its slot on the first switch, so it needs no stack or starting context of its own
+			m_TaskControl[MAX_TASKS].taskData = 0;
+			m_TaskControl[MAX_TASKS]._taskStack = 0;
+			m_TaskControl[MAX_TASKS].stackBottom = 0;
+			m_TaskControl[MAX_TASKS].stackSize = 0;
+			m_TaskControl[MAX_TASKS].contextPartial = false;
 	
-			//Set the max tasks control to the passed priority level
-			m_TaskControl[MAX_TASKS].priority = taskPriority;
+			//Set the max tasks control to the passed priority level, with a weight of 1
+			#if TASK_STRIDE_SCHEDULING
+			
+				m_TaskControl[MAX_TASKS].stride = TASK_STRIDE_ONE;
+				m_TaskControl[MAX_TASKS].pass = m_StridePass;
+			
+			#endif
+			
+			m_TaskPriority[MAX_TASKS] = taskPriority;
 			m_TaskControl[MAX_TASKS].cachedPriority = taskPriority;
+			
+			//Mark it as main now that its priority is set so it is filed in the right band
+			_WriteTaskStatus(MAX_TASKS, TASK_MAIN);
 		
 			//Set our current task to the last possible task, this way when entering for the first time we will loop to the first
+			m_TaskBlockIndex = MAX_TASKS;
+			m_RunPosition = MAX_TASKS;
 			m_CurrentTask = &m_TaskControl[MAX_TASKS];
 	
 			//Set our tasks running to true
@@ -243,72 +1457,282 @@ void StartTasks(void *mainfunc, TaskPriorityLevel_t taskPriority)
 	
 		);
 	
-		//wait while our tasks are running
-		while(m_blnTasksRunning == true);
+		//Wait while our tasks are running, blocked so we only run when nothing else can, unless our schedule takes turns through us.
+		//Once every task is gone we're switched back to
+		while(m_blnTasksRunning == true)
+		{
+			bool idle = false;
+			
+			TASK_CRITICAL_SECTION (
+				if(m_blnTasksRunning)
+				{
+					_WriteTaskStatus(MAX_TASKS, (_ScheduleRunsMain(m_TaskSchedule)) ? TASK_MAIN : TASK_BLOCKED);
+					
+					//If we're blocked and nobody else can run, we were only switched back to idle
+					idle = (m_TaskStatus[MAX_TASKS] == TASK_BLOCKED && (m_ReadyMask & ~((TaskMask_t)1 << MAX_TASKS)) == 0);
+				}
+				
+				#if TASK_IDLE_SLEEP && defined(__AVR)
+				
+					//Sleep until an interrupt instead of spinning through the switch. Interrupts go on with the sleep, so a wake can't slip in between
+					if(idle)
+					{
+						set_sleep_mode(SLEEP_MODE_IDLE);
+						sleep_enable();
+						sei();
+						sleep_cpu();
+						sleep_disable();
+					}
+				
+				#endif
+			);
+			
+			//With someone to run, hand over through the switch now. Else go around and sleep again, the tick switches to anyone it wakes
+			if(!idle)
+			{
+				TaskYieldNow();
+			}
+		}
+	
+		//Make sure our task index is reset back to 0 to allow us to more effectively
+		//launch tasks in the future. Covers some edge cases
+		m_TaskBlockCount = 0;
+	}
+
+}
+
+
+
+/**
+* \brief Attaches a task to the available tasks with a stack of TASK_STACK_SIZE
+* \param func The function for running the task
+* \param id The position to attach at as well as the tasks ID
+* \return The next id/index position
+*/
+TaskIndiceType_t AttachTask(void *func, TaskIndiceType_t id)
+{
+	return AttachTaskStack(func, id, TASK_STACK_SIZE);
+}
+
+
+
+/**
+* \brief Attaches the function at the slot with a stack of the size. Interrupts must be off.
+* \param func The function for running the task
+* \param id The position to attach at as well as the tasks ID
+* \param stackSize The bytes the task's stack needs
+* \param data The task data, passed to the function as its argument
+* \ret true if attached, false if the id is out of range or the stack doesn't fit
+*/
+static bool _TaskAttach(void *func, TaskIndiceType_t id, uint16_t stackSize, void *data)
+{
+	//If we don't have the ability to add a new block or our stack doesn't fit...
+	if(id >= MAX_TASKS || id < 0 || !_TaskStackAssign(id, stackSize))
+	{
+		return false;
+	}
+	
+	//If another ID is mapped to our slot, unmap it
+	if(m_TaskControl[id].taskID >= 0 && m_TaskSlot[m_TaskControl[id].taskID] == id)
+	{
+		m_TaskSlot[m_TaskControl[id].taskID] = -1;
+	}
+
+	//Set the task ID
+	m_TaskControl[id].taskID = id;
+	m_TaskSlot[id] = id;
+
+	//Set the function and its data
+	m_TaskControl[id].task_func = func;
+	m_TaskControl[id].taskData = data;
+
+	//Set our default timeouts
+	m_TaskTimeout[id] = 0;
+	m_TaskControl[id].defaultTimeout = 0;
+	m_TaskControl[id].reloadHeld = false;
+	_TaskTimeoutCancel(id);
+
+	//initialize stack pointer and program counter for our program execution
+	_TaskContextInit(id, func);
+
+	//Set our default priority and no deadline
+	m_TaskPriority[id] = 0;
+	
+	#if TASK_DEADLINES
+	
+		m_TaskControl[id].period = 0;
+		m_TaskControl[id].relativeDeadline = 0;
+		m_TaskControl[id].deadlineMisses = 0;
+		m_TaskControl[id].wcet = 0;
+		m_PeriodicMask &= ~((TaskMask_t)1 << id);
+	
+	#endif
+	
+	#if TASK_STRIDE_SCHEDULING
+	
+		//Default to a weight of 1
+		m_TaskControl[id].stride = TASK_STRIDE_ONE;
+		m_TaskControl[id].pass = m_StridePass;
+	
+	#endif
+	
+	//Not waiting on or holding anything
+	m_TaskControl[id].waitList = 0;
+	m_TaskControl[id].blockedOn = 0;
+	m_TaskControl[id].heldMutexes = 0;
+	m_TaskControl[id].waitState = TASK_WAIT_UNTIMED;
+	
+	#if TASK_JOIN
+	
+		//Nobody joined on us yet
+		m_TaskControl[id].joinHead = -1;
+		m_TaskControl[id].exitValue = 0;
+		m_TaskControl[id].joinedValue = 0;
+	
+	#endif
+
+	//Default to scheduled
+	_WriteTaskStatus(id, TASK_SCHEDULED);
+	
+	return true;
+}
+
+
+
+#if TASK_DEADLINES
+
+/**
+* \brief Makes the attached task at the slot periodic and releases it now. Interrupts must be off.
+* \param id The position the task is attached at
+* \param period The ticks between releases, also the deadline of each job
+* \param wcet The worst case ticks each job runs for
+*/
+static void _TaskMakePeriodic(TaskIndiceType_t id, TaskTimeout_t period, TaskTimeout_t wcet)
+{
+	//Set our period, deadline on our period, and worst case run time
+	m_TaskControl[id].period = period;
+	m_TaskControl[id].relativeDeadline = period;
+	m_TaskControl[id].wcet = wcet;
 	
-		//Make sure our task index is reset back to 0 to allow us to more effectively
-		//launch tasks in the future. Covers some edge cases
-		m_TaskBlockCount = 0;
-	}
+	//Mark us as periodic and release now
+	m_PeriodicMask |= ((TaskMask_t)1 << id);
+	_ReleaseTaskNow(id);
+}
+
+#endif
+
 
+
+/**
+* \brief Attaches a task to the available tasks with its own stack size. The stack is carved from the stack arena when TASK_STACK_ARENA_SIZE is set, \n
+* else it can be no more than TASK_STACK_SIZE
+* \param func The function for running the task
+* \param id The position to attach at as well as the tasks ID
+* \param stackSize The bytes the task's stack needs
+* \return The next id/index position, the same id if the stack doesn't fit
+*/
+TaskIndiceType_t AttachTaskStack(void *func, TaskIndiceType_t id, uint16_t stackSize)
+{
+	return AttachTaskData(func, id, stackSize, 0);
+}
+
+
+
+/**
+* \brief Attaches a task with its own stack size and data. The function is called with the data as its argument, \n
+* so one function taking a pointer can run as many tasks, each with its own data
+* \param func The function for running the task, taking a pointer
+* \param id The position to attach at as well as the tasks ID
+* \param stackSize The bytes the task's stack needs
+* \param data The task data, passed to the function
+* \return The next id/index position, the same id if the stack doesn't fit
+*/
+TaskIndiceType_t AttachTaskData(void *func, TaskIndiceType_t id, uint16_t stackSize, void *data)
+{
+	TASK_CRITICAL_SECTION (
+	
+		//If we attached, our count is up to the next id
+		if(_TaskAttach(func, id, stackSize, data))
+		{
+			id++;
+			m_TaskBlockCount = id;
+		}
+	);
+	
+	return id;
 }
 
 
 
+#if TASK_DEADLINES
+
 /**
-* \brief Attaches a task to the available tasks
+* \brief Attaches a periodic task. Its priority is given by its period when the tasks start, and the body should end each job with TaskWaitNextPeriod
 * \param func The function for running the task
 * \param id The position to attach at as well as the tasks ID
+* \param period The ticks between releases, also the deadline of each job
+* \param wcet The worst case ticks each job runs for, used by the admission check in StartTasks
 * \return The next id/index position
 */
-TaskIndiceType_t AttachTask(void *func, TaskIndiceType_t id)
+TaskIndiceType_t AttachPeriodicTask(void *func, TaskIndiceType_t id, TaskTimeout_t period, TaskTimeout_t wcet)
+{
+	const TaskIndiceType_t next = AttachTask(func, id);
+	
+	//If we attached and have a period and run time...
+	if(next > id && period > 0 && wcet > 0)
+	{
+		TASK_CRITICAL_SECTION ( _TaskMakePeriodic(id, period, wcet); );
+	}
+	
+	return next;
+}
+
+#endif
+
+
+
+/**
+* \brief Attaches every task of a table declared with TASK_TABLE_DEFINE, entry i at slot i, in one critical section. \n
+* Attaching stops at the first entry that doesn't fit, which can't happen with the arena the table was checked against.
+* \param table The table, in flash
+* \param count The entries in the table, see TASK_TABLE_COUNT
+* \return The count of tasks attached
+*/
+TaskIndiceType_t AttachTaskTable(const TaskTableEntry_t *table, TaskIndiceType_t count)
 {
+	TaskIndiceType_t id = 0;
+	
 	TASK_CRITICAL_SECTION (
 	
-		//If we have the ability to add a new block...
-		if(id < MAX_TASKS && id >= 0)
+		for(; id < count; id++)
 		{
-		
-			#ifdef RAMSTART
+			TaskTableEntry_t entry;
+			
+			//Copy the entry out of flash
+			#ifdef __AVR
+				memcpy_P(&entry, &table[id], sizeof(entry));
+			#else
+				entry = table[id];
+			#endif
+			
+			if(!_TaskAttach(entry.func, id, entry.stackSize, 0))
+			{
+				break;
+			}
+			
+			_WriteTaskPriority(id, entry.priority);
+			
+			#if TASK_DEADLINES
 			
-				//Check for allowances
-				if((TaskMemoryLocationType_t)_TASK_STACK_START_ADDRESS(id) < RAMSTART)
+				if(entry.period > 0 && entry.wcet > 0)
 				{
-					return id;	
+					_TaskMakePeriodic(id, entry.period, entry.wcet);
 				}
-				
+			
 			#endif
-		
-			//Set the memory location for our task stack
-			m_TaskControl[id]._taskStack = _TASK_STACK_START_ADDRESS(id);
-		
-			//Set the task ID
-			m_TaskControl[id].taskID = id;
-		
-			//Set the function
-			m_TaskControl[id].task_func = func;
-		
-			//Default to scheduled
-			m_TaskControl[id].taskStatus = TASK_SCHEDULED;
-		
-			//Set our default timeouts
-			m_TaskControl[id].timeout = 0;
-			m_TaskControl[id].defaultTimeout = 0;
-		
-			//initialize stack pointer and program counter for our program execution
-			m_TaskControl[id].taskExecutionContext.sp.ptr = ((uint8_t *)m_TaskControl[id]._taskStack);
-			m_TaskControl[id].taskExecutionContext.pc.ptr = func;
-		
-			//Set our default priority
-			m_TaskControl[id].priority = 0;
-		
-			//Increment our id
-			id++;
-		
-			//Set our count to be equal to the id
-			m_TaskBlockCount = id;
-		
 		}
+		
+		m_TaskBlockCount = id;
 	);
 	
 	return id;
@@ -331,36 +1755,83 @@ int8_t _KillTaskImmediate(TaskIndiceType_t index)
 	}
 	
 	//Set initially to blocked so we don't call the task
-	m_TaskControl[index].taskStatus = TASK_BLOCKED;
+	_WriteTaskStatus(index, TASK_BLOCKED);
+	
+	//Stop waiting, letting the owner of what we waited on drop the priority we lent it
+	_WaitListRemove(index);
+	
+	if(m_TaskControl[index].blockedOn != 0)
+	{
+		TaskMutex_t *mutex = m_TaskControl[index].blockedOn;
+		m_TaskControl[index].blockedOn = 0;
+		_MutexPropagatePriority(_GetTaskIndex(mutex->owner));
+	}
+	
+	//Hand on anything we hold
+	_MutexAbandon(index);
+	
+	#if TASK_JOIN
+	
+		//Wake everyone joined on us, with our exit value
+		for(TaskIndiceType_t joiner = _WaitListPop(&m_TaskControl[index].joinHead); joiner >= 0; joiner = _WaitListPop(&m_TaskControl[index].joinHead))
+		{
+			m_TaskControl[joiner].joinedValue = m_TaskControl[index].exitValue;
+			_TaskWake(joiner);
+		}
+	
+	#endif
 	
 	//Set the tasks stack address to 0
 	m_TaskControl[index]._taskStack = 0;
 		
-	//Loop through the tasks registers and...
-	for(TaskIndiceType_t i = 0; i < TASK_REGISTERS; i++)
-	{
-		//Clear
-		m_TaskControl[index].taskExecutionContext.registerFile[i] = 0;
-	}
+	#if !TASK_CONTEXT_ON_STACK
+	
+		//Loop through the tasks registers and...
+		for(TaskIndiceType_t i = 0; i < TASK_REGISTERS; i++)
+		{
+			//Clear
+			m_TaskControl[index].taskExecutionContext.registerFile[i] = 0;
+		}
+		
+		//Clear data
+		m_TaskControl[index].taskExecutionContext.pc.ptr = 0;
+		m_TaskControl[index].taskExecutionContext.sreg = 0;
+	
+	#endif
 	
-	//Clear data
-	m_TaskControl[index].taskExecutionContext.pc.ptr = 0;
 	m_TaskControl[index].taskExecutionContext.sp.ptr = 0;
-	m_TaskControl[index].taskExecutionContext.sreg = 0;
 	m_TaskControl[index].taskData = 0;
 	m_TaskControl[index].task_func = 0;
-	m_TaskControl[index].priority = 0;
+	m_TaskPriority[index] = 0;
 	
 	
-	//Reset our timeouts
-	m_TaskControl[index].timeout = 0;
+	//Reset our timeouts and deadline
+	_TaskTimeoutCancel(index);
+	m_TaskTimeout[index] = 0;
 	m_TaskControl[index].defaultTimeout = 0;
+	m_TaskControl[index].reloadHeld = false;
+	m_TaskControl[index].waitState = TASK_WAIT_UNTIMED;
+	
+	#if TASK_DEADLINES
+	
+		m_TaskControl[index].period = 0;
+		m_TaskControl[index].relativeDeadline = 0;
+		m_TaskControl[index].deadlineMisses = 0;
+		m_TaskControl[index].wcet = 0;
+		m_PeriodicMask &= ~((TaskMask_t)1 << index);
+	
+	#endif
+	
+	//Unmap and set the id to out of range
+	if(m_TaskControl[index].taskID >= 0 && m_TaskSlot[m_TaskControl[index].taskID] == index)
+	{
+		m_TaskSlot[m_TaskControl[index].taskID] = -1;
+	}
 	
-	//Set the id to out of range
 	m_TaskControl[index].taskID = -1;
 	
 	//Set the status as available
-	m_TaskControl[index].taskStatus = TASK_NONE;
+	_WriteTaskStatus(index, TASK_NONE);
 	
 	//Decrease our count
 	m_TaskBlockCount--;
@@ -385,11 +1856,29 @@ int8_t KillTask(TaskIndiceType_t index)
 		return 0;
 	}
 	
-	//Set the tasks status to kill
-	TASK_CRITICAL_SECTION ( m_TaskControl[index].taskStatus = TASK_KILL; );
+	//Set the tasks status to kill, if it is attached
+	TASK_CRITICAL_SECTION (
+		if(_GetTaskIndex(index) >= 0)
+		{
+			_WriteTaskStatus(_GetTaskIndex(index), TASK_KILL);
+		}
+	);
+	
+	#if TASK_JOIN
+	
+		//If it's another task, sleep until it's gone. The join only returns once it is, so there's nothing left to wait on
+		if(index != GetCurrentTaskID() && TaskJoin(index, TASK_WAIT_FOREVER, 0))
+		{
+			return 1;
+		}
 	
-	//Wait to be killed
-	while(m_TaskControl[index].taskStatus == TASK_KILL);
+	#endif
+	
+	//Else give up the processor until it's killed
+	while(GetTaskStatus(index) == TASK_KILL)
+	{
+		TaskYieldNow();
+	}
 	
 	//Return 1
 	return 1;
@@ -397,6 +1886,80 @@ int8_t KillTask(TaskIndiceType_t index)
 
 
 
+#if TASK_JOIN
+
+/**
+* \brief Blocks until the task with the passed ID exits, woken by its kill instead of checking on it
+* \param id The ID of the task to wait on
+* \param timeout The ticks to wait at most, TASK_WAIT_FOREVER to wait until it exits, 0 to only check
+* \param exitValue Where to put the value the task exited with, if not 0. 0 if it was already gone
+* \ret true if the task exited or was already gone, false if the timeout ran out, the tasks aren't running, or the task is us or the main task
+*/
+bool TaskJoin(TaskIndiceType_t id, TaskTimeout_t timeout, uint8_t *exitValue)
+{
+	bool exited = false;
+	bool waiting = false;
+	TaskIndiceType_t self = -1;
+	uint8_t value = 0;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//Get the slot for the ID
+		const TaskIndiceType_t index = _GetTaskIndex(id);
+		self = m_TaskBlockIndex;
+		
+		//If it isn't attached, it's already gone
+		if(index < 0)
+		{
+			exited = true;
+		}
+		//else if we can wait on it, wait in line with anyone else joined on it
+		else if(timeout != 0 && m_blnTasksRunning && index != self && index != MAX_TASKS)
+		{
+			_TaskBlockFor(self, &m_TaskControl[index].joinHead, TASK_WAIT_FIFO, timeout);
+			waiting = true;
+		}
+	);
+	
+	//Give up the processor until it exits or our timeout runs out
+	if(waiting)
+	{
+		exited = _TaskWaitWoken(self);
+		value = m_TaskControl[self].joinedValue;
+	}
+	
+	if(exited && exitValue != 0)
+	{
+		*exitValue = value;
+	}
+	
+	return exited;
+}
+
+
+
+/**
+* \brief Ends the calling task with the exit value, which is handed to every task joined on it. Doesn't return from a task. \n
+* The main task is never killed and nothing can join on it, so it is ignored there and returns straight away
+* \param value The exit value
+*/
+void TaskExit(uint8_t value)
+{
+	//The main task can't exit, or it would spin in the kill forever
+	if(!m_blnTasksRunning || m_TaskBlockIndex == MAX_TASKS)
+	{
+		return;
+	}
+	
+	TASK_CRITICAL_SECTION ( m_CurrentTask->exitValue = value; );
+	
+	KillTask(GetCurrentTaskID());
+}
+
+#endif
+
+
+
 /**
 * \brief Sets all tasks to be killed
 *
@@ -407,7 +1970,7 @@ int8_t KillAllTasks()
 	for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
 	{
 		//Set the tasks status to kill
-		TASK_CRITICAL_SECTION ( m_TaskControl[i].taskStatus = TASK_KILL; );
+		TASK_CRITICAL_SECTION ( _WriteTaskStatus(i, TASK_KILL); );
 	}
 	
 	//Return 1
@@ -424,40 +1987,74 @@ int8_t _KillAllTasksImmediate()
 {
 	
 	
+	//Take everyone out of the wait lists first, so nobody is handed a mutex as it is let go
+	for(TaskIndiceType_t index = 0; index <= MAX_TASKS; index++)
+	{
+		_WaitListRemove(index);
+		m_TaskControl[index].blockedOn = 0;
+		
+		#if TASK_JOIN
+		
+			m_TaskControl[index].joinHead = -1;
+		
+		#endif
+	}
+	
 	//Loop through all tasks and...
 	for(TaskIndiceType_t index = 0; index <= MAX_TASKS; index++)
 	{
 		//Set initially to blocked so we don't call the task
-		m_TaskControl[index].taskStatus = TASK_BLOCKED;
+		_WriteTaskStatus(index, TASK_BLOCKED);
+		
+		//Let go of anything we hold
+		_MutexAbandon(index);
 	
 		//Set the tasks stack address to 0
 		m_TaskControl[index]._taskStack = 0;
 		
-		//Loop through the tasks registers and...
-		for(TaskIndiceType_t i = 0; i < TASK_REGISTERS; i++)
-		{
-			//Clear
-			m_TaskControl[index].taskExecutionContext.registerFile[i] = 0;
-		}
-	
-		//Clear data
-		m_TaskControl[index].taskExecutionContext.pc.ptr = 0;
+		#if !TASK_CONTEXT_ON_STACK
+		
+			//Loop through the tasks registers and...
+			for(TaskIndiceType_t i = 0; i < TASK_REGISTERS; i++)
+			{
+				//Clear
+				m_TaskControl[index].taskExecutionContext.registerFile[i] = 0;
+			}
+		
+			//Clear data
+			m_TaskControl[index].taskExecutionContext.pc.ptr = 0;
+			m_TaskControl[index].taskExecutionContext.sreg = 0;
+		
+		#endif
+		
 		m_TaskControl[index].taskExecutionContext.sp.ptr = 0;
-		m_TaskControl[index].taskExecutionContext.sreg = 0;
 		m_TaskControl[index].taskData = 0;
 		m_TaskControl[index].task_func = 0;
-		m_TaskControl[index].priority = 0;
+		m_TaskPriority[index] = 0;
 		
-		//Reset our timeouts
-		m_TaskControl[index].timeout = 0;
+		//Reset our timeouts and deadline
+		m_TaskTimeout[index] = 0;
 		m_TaskControl[index].defaultTimeout = 0;
+		_TaskTimeoutCancel(index);
+		m_TaskControl[index].reloadHeld = false;
+		m_TaskControl[index].waitState = TASK_WAIT_UNTIMED;
+		
+		#if TASK_DEADLINES
+		
+			m_TaskControl[index].period = 0;
+			m_TaskControl[index].relativeDeadline = 0;
+			m_TaskControl[index].deadlineMisses = 0;
+			m_TaskControl[index].wcet = 0;
+		
+		#endif
 
 	
-		//Set the id to out of range
+		//Unmap and set the id to out of range
+		m_TaskSlot[index] = -1;
 		m_TaskControl[index].taskID = -1;
 	
 		//Set the status as available
-		m_TaskControl[index].taskStatus = TASK_NONE;
+		_WriteTaskStatus(index, TASK_NONE);
 	
 		//Decrease our count
 		m_TaskBlockCount--;
@@ -465,6 +2062,13 @@ int8_t _KillAllTasksImmediate()
 	
 	
 	
+	#if TASK_DEADLINES
+	
+		//Nobody is periodic anymore
+		m_PeriodicMask = 0;
+	
+	#endif
+	
 	//Return 1
 	return 1;
 	
@@ -480,8 +2084,8 @@ int8_t _KillAllTasksImmediate()
 */
 void TaskSleep(TaskIndiceType_t taskIndex, TaskTimeout_t counts)
 {
-	//If our index is out of range...
-	if (taskIndex < 0 || taskIndex > MAX_TASKS)
+	//If our ID is not attached...
+	if (_GetTaskIndex(taskIndex) < 0)
 	{
 		//return
 		return;
@@ -492,39 +2096,74 @@ void TaskSleep(TaskIndiceType_t taskIndex, TaskTimeout_t counts)
 	TASK_CRITICAL_SECTION (
 	
 		//Save our tasks status
-		volatile TaskStatus_t savedStatus = m_TaskControl[taskIndex].taskStatus;
+		volatile TaskStatus_t savedStatus = m_TaskStatus[_GetTaskIndex(taskIndex)];
 	
 		//Save our timeout counts
-		m_TaskControl[taskIndex].timeout = counts;
+		m_TaskTimeout[_GetTaskIndex(taskIndex)] = counts;
 	
 		//Make sure we're set to sleep
-		m_TaskControl[taskIndex].taskStatus = TASK_SLEEP;
+		_WriteTaskStatus(_GetTaskIndex(taskIndex), TASK_SLEEP);
 	);
 
 	
 	//While timed out, count down
-	while(m_TaskControl[taskIndex].timeout > 0)
+	while(m_TaskTimeout[_GetTaskIndex(taskIndex)] > 0)
 	{
-		m_TaskControl[taskIndex].taskStatus = TASK_SLEEP;
-		m_TaskControl[taskIndex].timeout -= 1;
+		m_TaskStatus[_GetTaskIndex(taskIndex)] = TASK_SLEEP;
+		m_TaskTimeout[_GetTaskIndex(taskIndex)] -= 1;
 	}
 	
 	//Revert back to our saved status before exiting
-	m_TaskControl[taskIndex].taskStatus = savedStatus;
+	TASK_CRITICAL_SECTION ( _WriteTaskStatus(_GetTaskIndex(taskIndex), savedStatus); );
 	
 }
 
 
 
 /**
-* \brief Sets this task to yield for the specified amount of counts, counting down in the scheduler interrupt
+* \brief Sets this task to yield for the specified amount of counts, woken by the scheduler once they have passed
 * \param taskIndex The index of the task to sleep, which if ran correctly should be the tasks ID
-* \param counts The amount of counts to wait for
+* \param counts The amount of scheduler ticks to wait for, at least 1
 */
 void TaskSetYield(TaskIndiceType_t taskIndex, TaskTimeout_t counts)
 {
-	//If our task is out of range...
-	if (taskIndex < 0 || taskIndex > MAX_TASKS)
+	//If our ID is not attached...
+	if (_GetTaskIndex(taskIndex) < 0)
+	{
+		//return
+		return;
+	}
+	
+	//Disable interrupts and re-enable after code is executed
+	TASK_CRITICAL_SECTION (
+		
+		//Set our status
+		_WriteTaskStatus(_GetTaskIndex(taskIndex), TASK_YIELD);
+	
+		//Arm our wake up
+		_TaskTimeoutArm(_GetTaskIndex(taskIndex), _TimerTicks() + ((counts > 0) ? counts : 1));
+	);
+	
+	
+	
+	//Give up the processor while yielded
+	while(GetTaskStatus(taskIndex) == TASK_YIELD)
+	{
+		TaskYieldNow();
+	}
+}
+
+
+
+/**
+* \brief Sets this task to yield until the passed scheduler tick, woken by the scheduler once it is reached. For waits too long for a timeout count, or for keeping to a period
+* \param taskIndex The index of the task to sleep, which if ran correctly should be the tasks ID
+* \param wakeTick The scheduler tick to wake at. Ticks that have already passed wake on the next tick
+*/
+void TaskYieldUntil(TaskIndiceType_t taskIndex, TaskTick_t wakeTick)
+{
+	//If our ID is not attached...
+	if (_GetTaskIndex(taskIndex) < 0)
 	{
 		//return
 		return;
@@ -534,18 +2173,73 @@ void TaskSetYield(TaskIndiceType_t taskIndex, TaskTimeout_t counts)
 	TASK_CRITICAL_SECTION (
 		
 		//Set our status
-		m_TaskControl[taskIndex].taskStatus = TASK_YIELD;
+		_WriteTaskStatus(_GetTaskIndex(taskIndex), TASK_YIELD);
+	
+		//Arm our wake up
+		_TaskTimeoutArm(_GetTaskIndex(taskIndex), wakeTick);
+	);
+	
+	
+	
+	//Give up the processor while yielded
+	while(GetTaskStatus(taskIndex) == TASK_YIELD)
+	{
+		TaskYieldNow();
+	}
+}
+
+
+
+#if TASK_DEADLINES
+
+/**
+* \brief Ends the current job of a periodic task and yields until its next release, counting a miss if the job finished after its deadline
+* \param taskIndex The index of the task, which if ran correctly should be the tasks ID
+*/
+void TaskWaitNextPeriod(TaskIndiceType_t taskIndex)
+{
+	//If our ID is not attached...
+	if (_GetTaskIndex(taskIndex) < 0 || _GetTaskIndex(taskIndex) >= MAX_TASKS)
+	{
+		//return
+		return;
+	}
 	
-		//Set our sleep count
-		m_TaskControl[taskIndex].timeout = counts;
+	//Disable interrupts and re-enable after code is executed
+	TASK_CRITICAL_SECTION (
+		
+		const TaskIndiceType_t index = _GetTaskIndex(taskIndex);
+		
+		//If we're periodic...
+		if(m_TaskControl[index].period > 0)
+		{
+			//If we finished after our deadline, count it
+			if(m_TaskControl[index].relativeDeadline > 0 && (int32_t)(_TimerTicks() - m_TaskControl[index].absoluteDeadline) > 0)
+			{
+				m_TaskControl[index].deadlineMisses++;
+			}
+			
+			//Move to our next release, kept on the period so it does not drift
+			m_TaskControl[index].release += m_TaskControl[index].period;
+			m_TaskControl[index].absoluteDeadline = m_TaskControl[index].release + m_TaskControl[index].relativeDeadline;
+			
+			//Yield until then
+			_WriteTaskStatus(index, TASK_YIELD);
+			_TaskTimeoutArm(index, m_TaskControl[index].release);
+		}
 	);
 	
 	
 	
-	//Wait while yielded
-	while(m_TaskControl[taskIndex].taskStatus == TASK_YIELD);
+	//Give up the processor while yielded
+	while(GetTaskStatus(taskIndex) == TASK_YIELD)
+	{
+		TaskYieldNow();
+	}
 }
 
+#endif
+
 
 
 /**
@@ -566,7 +2260,16 @@ inline void DispatchTasks()
 */
 inline void SetTaskSchedule(TaskSchedule_t schedule)
 {
-	TASK_CRITICAL_SECTION ( m_TaskSchedule = schedule; );
+	TASK_CRITICAL_SECTION (
+	
+		m_TaskSchedule = schedule;
+		
+		//If the main task is out of the way in StartTasks and the schedule now takes turns through it, it has to be runnable again
+		if(m_blnTasksRunning && _ScheduleRunsMain(schedule) && m_TaskStatus[MAX_TASKS] == TASK_BLOCKED && m_TaskControl[MAX_TASKS].waitList == 0)
+		{
+			_TaskWake(MAX_TASKS);
+		}
+	);
 }
 
 
@@ -625,7 +2328,7 @@ int8_t KillOtherTasks(TaskIndiceType_t tid)
 			if(m_TaskControl[i].taskID != tid)
 			{
 				//Set the tasks status to kill
-				m_TaskControl[i].taskStatus = TASK_KILL; 	
+				_WriteTaskStatus(i, TASK_KILL);
 			}
 			
 		}
@@ -651,11 +2354,11 @@ TaskIndiceType_t GetActiveTaskCount()
 		
 		for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
 		{
-			if(m_TaskControl[i].taskStatus == TASK_READY || m_TaskControl[i].taskStatus == TASK_YIELD || m_TaskControl[i].taskStatus == TASK_SCHEDULED || m_TaskControl[i].taskStatus == TASK_SLEEP)
+			if(m_TaskStatus[i] == TASK_READY || m_TaskStatus[i] == TASK_YIELD || m_TaskStatus[i] == TASK_SCHEDULED || m_TaskStatus[i] == TASK_SLEEP)
 			{
 				count++;
 			}
-			else if(m_TaskControl[i].taskStatus == TASK_MAIN && (TaskMemoryLocationType_t)m_TaskControl[MAX_TASKS].task_func != (TaskMemoryLocationType_t)_EmptyTask )
+			else if(m_TaskStatus[i] == TASK_MAIN && (TaskMemoryLocationType_t)m_TaskControl[MAX_TASKS].task_func != (TaskMemoryLocationType_t)_EmptyTask )
 			{
 				count++;
 			}
@@ -690,13 +2393,16 @@ bool IsTaskActive(TaskIndiceType_t tid)
 	//Enter critical section to check...
 	TASK_CRITICAL_SECTION (
 		
-		//If the passed task id is within range...
-		if(tid >= 0 && tid <= MAX_TASKS)
+		//Get the slot for the passed task id
+		const TaskIndiceType_t index = _GetTaskIndex(tid);
+		
+		//If the passed task id is attached...
+		if(index >= 0)
 		{
 			//If our task status is acceptable...
-			if(m_TaskControl[tid].taskStatus == TASK_READY || m_TaskControl[tid].taskStatus == TASK_YIELD
-			|| m_TaskControl[tid].taskStatus == TASK_SCHEDULED || m_TaskControl[tid].taskStatus == TASK_MAIN
-			|| m_TaskControl[tid].taskStatus == TASK_SLEEP)
+			if(m_TaskStatus[index] == TASK_READY || m_TaskStatus[index] == TASK_YIELD
+			|| m_TaskStatus[index] == TASK_SCHEDULED || m_TaskStatus[index] == TASK_MAIN
+			|| m_TaskStatus[index] == TASK_SLEEP)
 			{
 				//Set our tasks state to true
 				taskState = true;
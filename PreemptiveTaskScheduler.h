@@ -47,6 +47,24 @@ extern "C" {
 ///Used for the semaphore request block, executes any passed arguments before requesting
 #define TASK_SEM_REQUEST_BLOCK(...) __VA_ARGS__; for(TaskIndiceType_t _____sem __attribute__((__cleanup__(__iExitSem))) = OpenSemaphoreRequest(true); _____sem;)
 
+///Static initializer for a mutex, for when MutexInit can't be called first
+#define TASK_MUTEX_INIT { -1, 0, -1, 0 }
+
+///Static initializer for a semaphore, for when SemaphoreInit can't be called first
+#define TASK_SEMAPHORE_INIT(count, limit, order) { (count), (limit), -1, (order) }
+
+///Timeout for waiting until woken, no matter how long it takes
+#define TASK_WAIT_FOREVER	-1
+
+///Static initializer for an event group with no bits set
+#define TASK_EVENT_GROUP_INIT { 0, -1 }
+
+///Event wait option, wait until all of the bits are set instead of any
+#define TASK_EVENT_WAIT_ALL			0x01
+
+///Event wait option, clear the bits waited on when the wait is satisfied
+#define TASK_EVENT_CLEAR_ON_EXIT	0x02
+
 
 
 ///Macro reference to the ID gotten during the current task sections
@@ -77,23 +95,101 @@ extern TaskControl_t* GetTask(void *task_func);
 extern TaskPriorityLevel_t FindNextHighestPriorityLevel();
 extern TaskIndiceType_t FindNextHighestPriorityTask();
 extern TaskIndiceType_t FindNextPriorityTask();
+extern TaskIndiceType_t FindNextReadyPriorityTask();
+extern TaskIndiceType_t FindNextReadyTask(TaskIndiceType_t after);
+extern TaskIndiceType_t FindNextOrderedTask();
+#if TASK_DEADLINES
+extern TaskIndiceType_t FindNextDeadlineTask();
+extern TaskIndiceType_t FindNextRateMonotonicTask();
+#endif
+#if TASK_STRIDE_SCHEDULING
+extern TaskIndiceType_t FindNextStrideTask();
+#endif
 extern uint8_t OpenSemaphoreRequest(bool waitForAccess);
 extern uint8_t CloseSemaphoreRequest();
+extern void MutexInit(TaskMutex_t *mutex);
+extern void MutexLock(TaskMutex_t *mutex);
+extern uint8_t MutexTryLock(TaskMutex_t *mutex);
+extern uint8_t MutexUnlock(TaskMutex_t *mutex);
+extern void SemaphoreInit(TaskSemaphore_t *sem, SemaphoreValueType_t count, SemaphoreValueType_t limit, TaskWaitOrder_t order);
+extern void SemaphoreTake(TaskSemaphore_t *sem);
+extern uint8_t SemaphoreTryTake(TaskSemaphore_t *sem);
+extern uint8_t SemaphoreTakeTimeout(TaskSemaphore_t *sem, TaskTimeout_t timeout);
+extern uint8_t SemaphoreGive(TaskSemaphore_t *sem);
+extern uint8_t SemaphoreGiveFromISR(TaskSemaphore_t *sem);
+extern SemaphoreValueType_t SemaphoreGetCount(TaskSemaphore_t *sem);
+extern void QueueInit(TaskQueue_t *queue, void *storage, uint8_t itemSize, uint8_t capacity);
+extern uint8_t QueueSend(TaskQueue_t *queue, const void *item, TaskTimeout_t timeout);
+extern uint8_t QueueReceive(TaskQueue_t *queue, void *item, TaskTimeout_t timeout);
+extern uint8_t QueueSendBuffer(TaskQueue_t *queue, void *buffer, TaskTimeout_t timeout);
+extern void* QueueReceiveBuffer(TaskQueue_t *queue, TaskTimeout_t timeout);
+extern uint8_t QueueGetCount(TaskQueue_t *queue);
+extern void PoolInit(TaskPool_t *pool, void *storage, uint8_t blockSize, uint8_t blockCount);
+extern void* PoolAlloc(TaskPool_t *pool, TaskTimeout_t timeout);
+extern void PoolFree(TaskPool_t *pool, void *block);
+extern TaskIndiceType_t AttachDeferredWorker(TaskIndiceType_t id, TaskPriorityLevel_t priority, uint16_t stackSize);
+extern uint8_t DeferWork(void (*func)(void *arg), void *arg);
+extern uint8_t DeferWorkFromISR(void (*func)(void *arg), void *arg);
+extern uint8_t GetDeferredWorkDepthMax(void);
+extern uint16_t GetDeferredWorkOverflows(void);
+extern TaskIndiceType_t AttachTimerDaemon(TaskIndiceType_t id, TaskPriorityLevel_t priority, uint16_t stackSize);
+extern void SoftTimerInit(TaskSoftTimer_t *timer, void (*callback)(void *arg), void *arg, TaskTimeout_t period, bool autoReload);
+extern void SoftTimerStart(TaskSoftTimer_t *timer);
+extern void SoftTimerStop(TaskSoftTimer_t *timer);
+extern void SoftTimerReset(TaskSoftTimer_t *timer);
+extern void SoftTimerChangePeriod(TaskSoftTimer_t *timer, TaskTimeout_t period);
+extern bool SoftTimerIsActive(TaskSoftTimer_t *timer);
+#if TASK_EVENT_GROUPS
+extern void EventGroupInit(TaskEventGroup_t *group);
+extern TaskEventBits_t EventGroupWait(TaskEventGroup_t *group, TaskEventBits_t mask, uint8_t options, TaskTimeout_t timeout);
+extern TaskEventBits_t EventGroupSet(TaskEventGroup_t *group, TaskEventBits_t bits);
+extern TaskEventBits_t EventGroupSetFromISR(TaskEventGroup_t *group, TaskEventBits_t bits);
+extern TaskEventBits_t EventGroupClear(TaskEventGroup_t *group, TaskEventBits_t bits);
+extern TaskEventBits_t EventGroupGet(TaskEventGroup_t *group);
+#endif
 extern void SetTaskDefaultTimeout(TaskIndiceType_t id, TaskTimeout_t timeout);
 extern void SetTaskSchedule(TaskSchedule_t schedule);
 extern void SetTaskPriority(TaskIndiceType_t id, TaskPriorityLevel_t priority);
+#if TASK_STRIDE_SCHEDULING
+extern void SetTaskWeight(TaskIndiceType_t id, uint8_t weight);
+#endif
+#if TASK_DEADLINES
+extern void SetTaskDeadline(TaskIndiceType_t id, TaskTimeout_t period, TaskTimeout_t relativeDeadline);
+extern uint16_t GetTaskDeadlineMisses(TaskIndiceType_t id);
+#endif
 extern const bool AreTaskRunning();
 extern const TaskIndiceType_t GetCurrentTaskID();
 extern TaskIndiceType_t _GetTaskIndex(TaskIndiceType_t id);
+extern TaskIndiceType_t _GetCurrentTaskIndex();
 extern TaskStatus_t GetTaskStatus(TaskIndiceType_t id);
 extern void SetTaskStatus(TaskIndiceType_t id, TaskStatus_t status);
 extern TaskIndiceType_t AttachTask(void *func, TaskIndiceType_t id);
+extern TaskIndiceType_t AttachTaskStack(void *func, TaskIndiceType_t id, uint16_t stackSize);
+extern TaskIndiceType_t AttachTaskData(void *func, TaskIndiceType_t id, uint16_t stackSize, void *data);
+extern void *GetTaskData(TaskIndiceType_t id);
+extern uint16_t GetTaskStackHighWater(TaskIndiceType_t id);
+extern void TaskStackOverflow(TaskIndiceType_t id);
+#if TASK_DEADLINES
+extern TaskIndiceType_t AttachPeriodicTask(void *func, TaskIndiceType_t id, TaskTimeout_t period, TaskTimeout_t wcet);
+extern bool ArePeriodicTasksSchedulable();
+#endif
+extern TaskIndiceType_t AttachTaskTable(const TaskTableEntry_t *table, TaskIndiceType_t count);
 extern int8_t KillTask(TaskIndiceType_t index);
+#if TASK_JOIN
+extern bool TaskJoin(TaskIndiceType_t id, TaskTimeout_t timeout, uint8_t *exitValue);
+extern void TaskExit(uint8_t value);
+#endif
 extern int8_t KillAllTasks();
 extern void DispatchTasks();
 extern void StartTasks(void *mainfunc, TaskPriorityLevel_t taskPriority);
 extern void TaskSleep(TaskIndiceType_t taskIndex, TaskTimeout_t counts);
 extern void TaskSetYield(TaskIndiceType_t taskIndex, TaskTimeout_t counts);
+extern void TaskYieldUntil(TaskIndiceType_t taskIndex, TaskTick_t wakeTick);
+#if TASK_DEADLINES
+extern void TaskWaitNextPeriod(TaskIndiceType_t taskIndex);
+#endif
+extern void TaskYieldNow(void);
+extern TaskTick_t GetSchedulerTicks();
 
 //-----------------------------------
 
@@ -104,6 +200,38 @@ extern const TaskIndiceType_t _GetTaskID(TaskIndiceType_t index);
 extern int8_t _KillTaskImmediate(TaskIndiceType_t index);
 extern int8_t _KillAllTasksImmediate();
 extern void _EmptyTask(void);
+extern void _WriteTaskStatus(TaskIndiceType_t index, TaskStatus_t status);
+extern void _WriteTaskPriority(TaskIndiceType_t index, TaskPriorityLevel_t priority);
+extern TaskPriorityLevel_t _ReadTaskPriority(TaskIndiceType_t index);
+extern void _TicklessWake(void);
+extern uint16_t _TicklessElapsedSlices(void);
+extern void _TaskTimeoutArm(TaskIndiceType_t index, TaskTick_t deadline);
+extern void _TaskTimeoutCancel(TaskIndiceType_t index);
+#if TASK_DEADLINES
+extern void _AssignRateMonotonicPriorities(void);
+#endif
+extern TaskControl_t* _GetTaskControl(TaskIndiceType_t index);
+extern void _WaitListInsert(TaskIndiceType_t *head, TaskIndiceType_t index);
+extern void _WaitListRemove(TaskIndiceType_t index);
+extern TaskIndiceType_t _WaitListPop(TaskIndiceType_t *head);
+extern void _WaitListAppend(TaskIndiceType_t *head, TaskIndiceType_t index);
+extern void _TaskBlock(TaskIndiceType_t index, TaskIndiceType_t *head);
+extern void _TaskBlockFor(TaskIndiceType_t index, TaskIndiceType_t *head, TaskWaitOrder_t order, TaskTimeout_t timeout);
+extern bool _TaskWaitWoken(TaskIndiceType_t index);
+extern void _TaskWake(TaskIndiceType_t index);
+extern void _MutexAbandon(TaskIndiceType_t index);
+extern void _MutexPropagatePriority(TaskIndiceType_t index);
+extern void _TimerInsert(TaskTimerNode_t *node, TaskTick_t deadline);
+extern void _TimerRemove(TaskTimerNode_t *node);
+extern bool _TimerIsArmed(TaskTimerNode_t *node);
+extern void _TimerService(uint16_t elapsed);
+extern uint16_t _TimerTicksUntilNext(uint16_t limit);
+extern TaskTick_t _TimerTicks(void);
+extern uint8_t _HighestSetBit8(uint8_t value);
+extern TaskIndiceType_t _LowestSetBit(TaskMask_t mask);
+extern TaskIndiceType_t _NextSetBitAfter(TaskMask_t mask, TaskIndiceType_t after);
+extern bool _IsRunnableStatus(TaskStatus_t status);
+extern uint8_t _PriorityBand(TaskPriorityLevel_t priority);
 
 //-----------------------------------
 
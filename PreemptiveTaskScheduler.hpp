@@ -0,0 +1,217 @@
+/**
+ * \file PreemptiveTaskScheduler.hpp
+ * \author: Tim Robbins
+ * \brief C++ scope guards and task objects for preemptive task scheduling and concurrent functionality. \n
+ *
+ * Everything here is inline and only wraps the C functions and macros, so it costs about what the macros do. \n
+ * Unlike TASK_CRITICAL_SECTION_LOCK and TASK_SWITCHING_LOCK, the guards are left on return and break, and nest: \n
+ * \code
+ * void Push(uint8_t value)
+ * {
+ *	TaskScheduler::InterruptGuard guard;
+ *
+ *	if(m_Count == sizeof(m_Buffer))
+ *	{
+ *		return; //Interrupts are put back as they were
+ *	}
+ *
+ *	m_Buffer[m_Count++] = value;
+ * }
+ *
+ * static TaskScheduler::Task<96, 2> m_Blinker(0);
+ * Channel m_Channel; //Before C++17, a bound argument can't be static
+ * static void ReadChannel(Channel &channel);
+ *
+ * m_Blinker.Attach<Channel, ReadChannel, m_Channel>();
+ * \endcode
+ */
+#ifndef __PREEMPTIVETASKSCHEDULER_HPP__
+#define __PREEMPTIVETASKSCHEDULER_HPP__	1
+
+
+
+#include "PreemptiveTaskScheduler.h"
+
+
+
+namespace TaskScheduler
+{
+
+
+
+/**
+* \brief Turns interrupts off for its scope, then puts the status register back as it was. \n
+* Nested guards, or a guard in an interrupt, leave interrupts off until the outermost one ends.
+*/
+class InterruptGuard
+{
+public:
+
+	__attribute__((always_inline)) InterruptGuard() : m_sreg(SCHEDULER_ASM_SREG_SAVE())
+	{
+		SCHEDULER_ASM_INTERRUPTS_OFF();
+	}
+
+	__attribute__((always_inline)) ~InterruptGuard()
+	{
+		SCHEDULER_ASM_SREG_RESTORE(m_sreg);
+	}
+
+	InterruptGuard(const InterruptGuard &) = delete;
+	InterruptGuard &operator=(const InterruptGuard &) = delete;
+
+private:
+
+	///The status register from before the guard
+	const uint8_t m_sreg;
+};
+
+
+
+/**
+* \brief Stops the scheduler tick for its scope, so the task isn't switched out unless it yields or blocks. \n
+* Interrupts stay on. Nested locks only start the tick again when the outermost one ends.
+*/
+class SchedulerLock
+{
+public:
+
+	__attribute__((always_inline)) SchedulerLock()
+	{
+		if(_Depth()++ == 0)
+		{
+			_SCHEDULER_STOP_TICK();
+		}
+	}
+
+	__attribute__((always_inline)) ~SchedulerLock()
+	{
+		if(--_Depth() == 0)
+		{
+			_SCHEDULER_START_TICK();
+		}
+	}
+
+	SchedulerLock(const SchedulerLock &) = delete;
+	SchedulerLock &operator=(const SchedulerLock &) = delete;
+
+private:
+
+	///The count of locks held. Balanced by every task, so a switch between its read and write finds it as it left it
+	static __attribute__((always_inline)) uint8_t &_Depth()
+	{
+		static uint8_t depth;
+		return depth;
+	}
+};
+
+
+
+/**
+* \brief A task at a fixed ID, with its stack size and priority given at compile time. \n
+* Attaching again replaces what was attached. If still attached and running when it ends, the task is killed.
+*/
+template<uint16_t StackBytes = TASK_STACK_SIZE, TaskPriorityLevel_t Priority = 0>
+class Task
+{
+	static_assert(TASK_STACK_ARENA_SIZE > 0 || StackBytes <= TASK_STACK_SIZE, "Task stack can't be bigger than TASK_STACK_SIZE without a stack arena");
+	static_assert(TASK_STACK_ARENA_SIZE == 0 || StackBytes <= TASK_STACK_ARENA_SIZE, "Task stack doesn't fit in the stack arena");
+
+public:
+
+	explicit constexpr Task(TaskIndiceType_t id) : m_id(id), m_attached(false)
+	{
+	}
+
+	~Task()
+	{
+		if(m_attached && AreTaskRunning() && IsTaskActive(m_id))
+		{
+			KillTask(m_id);
+		}
+	}
+
+	Task(const Task &) = delete;
+	Task &operator=(const Task &) = delete;
+
+	/**
+	* \brief Attaches the function as our task
+	* \param func The function for running the task
+	* \ret true if attached, false if the ID is out of range or the stack doesn't fit
+	*/
+	bool Attach(void (*func)(void))
+	{
+		return Attach<void>((void (*)(void *))func, 0);
+	}
+
+	/**
+	* \brief Attaches the function as our task, called with the data. One function can run as many tasks, each with its own data
+	* \param func The function for running the task
+	* \param data The task data, passed to the function
+	* \ret true if attached, false if the ID is out of range or the stack doesn't fit
+	*/
+	template<typename T>
+	bool Attach(void (*func)(T *), T *data)
+	{
+		m_attached = (AttachTaskData((void *)func, m_id, StackBytes, (void *)data) > m_id);
+
+		if(m_attached)
+		{
+			SetTaskPriority(m_id, Priority);
+		}
+
+		return m_attached;
+	}
+
+	/**
+	* \brief Attaches the function as our task, called with the argument. The argument is bound at compile time, so nothing is stored for it
+	* \ret true if attached, false if the ID is out of range or the stack doesn't fit
+	*/
+	template<typename T, void (*Func)(T &), T &Arg>
+	bool Attach()
+	{
+		return Attach(&_Entry<T, Func, Arg>);
+	}
+
+	///Returns our task ID
+	constexpr TaskIndiceType_t Id() const
+	{
+		return m_id;
+	}
+
+	///Returns the status of our task
+	TaskStatus_t Status() const
+	{
+		return GetTaskStatus(m_id);
+	}
+
+	///Kills our task, returning once it's gone
+	void Kill()
+	{
+		KillTask(m_id);
+		m_attached = false;
+	}
+
+private:
+
+	///Calls the function with its argument when the task starts
+	template<typename T, void (*Func)(T &), T &Arg>
+	static void _Entry(void)
+	{
+		Func(Arg);
+	}
+
+	///Our task ID
+	const TaskIndiceType_t m_id;
+
+	///If we attached our task
+	bool m_attached;
+};
+
+
+
+}
+
+
+
+#endif /* __PREEMPTIVETASKSCHEDULER_HPP__ */
@@ -20,6 +20,21 @@
 ///Return statement from interrupt
 #define __SCHEDULER_ISR_ASM_RETURN()			__asm__ __volatile__("reti \n"::)
 
+///Keeps the compiler from moving memory accesses across this point
+#define SCHEDULER_ASM_MEMORY_BARRIER()		__asm__ __volatile__("":::"memory")
+
+///Evaluates to the stack pointer, the next free byte of the stack we're running on
+#define SCHEDULER_ASM_STACK_POINTER()		__extension__({ uint16_t __sp; __asm__ __volatile__("in %A0, __SP_L__ \n\t" "in %B0, __SP_H__ \n\t" : "=r" (__sp)); (uint8_t *)__sp; })
+
+///Evaluates true if global interrupts are enabled, false if in an interrupt or critical section
+#define SCHEDULER_ASM_INTERRUPTS_ENABLED()	__extension__({ uint8_t __sreg; __asm__ __volatile__("in %0, __SREG__ \n\t" : "=r" (__sreg)); (__sreg & 0x80) != 0; })
+
+///Evaluates to the status register, to put back later with SCHEDULER_ASM_SREG_RESTORE
+#define SCHEDULER_ASM_SREG_SAVE()			__extension__({ uint8_t __sreg; __asm__ __volatile__("in %0, __SREG__ \n\t" : "=r" (__sreg) :: "memory"); __sreg; })
+
+///Puts back a status register saved with SCHEDULER_ASM_SREG_SAVE, turning interrupts back on only if they were on
+#define SCHEDULER_ASM_SREG_RESTORE(_sreg)	__asm__ __volatile__("out __SREG__, %0 \n\t" :: "r" ((uint8_t)(_sreg)) : "memory")
+
 #endif
 
 
@@ -129,13 +144,13 @@ asm volatile(  \
 	"ld r30, Y+ \n\t"                                                  \
 	"ld r31, Y  \n\t" \
 	"pop r29 \n\t"                                                     \
-	"pop r28 \n\t"::)
+	"pop r28 \n\t" \
+	"clr r1 \n\t"::)
 
 
 
 ///Restores program context position. See naked function for comments.
-#define _ASM_RESTORE_CONTEXT(_z_load_cmds) \
-asm volatile( \
+#define _ASM_RESTORE_CONTEXT_CMDS(_z_load_cmds) \
 	_z_load_cmds \
 	"adiw r30, CONTEXT_OFFSET_SP_H \n\t" \
 	"cli \n\t" \
@@ -190,10 +205,298 @@ asm volatile( \
 	"out __SREG__, r0 \n\t" \
 	"pop r0 \n\t" \
 	"pop r30 \n\t" \
-	"pop r31 \n\t"::)
+	"pop r31 \n\t"
+
+///Runs _ASM_RESTORE_CONTEXT_CMDS as its own asm block
+#define _ASM_RESTORE_CONTEXT(_z_load_cmds) asm volatile( _ASM_RESTORE_CONTEXT_CMDS(_z_load_cmds) ::)
+
+
+
+
+
+///Pushes program context onto the stack under the return address and saves the stack pointer at the start of the X loaded context. \n
+///Frame from the top down: return address, r0, SREG, r1 to r31. r1 is cleared after for the C code that follows
+#define _ASM_PUSH_CONTEXT(_x_load_cmds) \
+asm volatile(  \
+	"push r0 \n\t" \
+	"in r0, __SREG__ \n\t" \
+	"cli \n\t" \
+	"push r0 \n\t" \
+	"push r1 \n\t" \
+	"clr r1 \n\t" \
+	"push r2 \n\t" \
+	"push r3 \n\t" \
+	"push r4 \n\t" \
+	"push r5 \n\t" \
+	"push r6 \n\t" \
+	"push r7 \n\t" \
+	"push r8 \n\t" \
+	"push r9 \n\t" \
+	"push r10 \n\t" \
+	"push r11 \n\t" \
+	"push r12 \n\t" \
+	"push r13 \n\t" \
+	"push r14 \n\t" \
+	"push r15 \n\t" \
+	"push r16 \n\t" \
+	"push r17 \n\t" \
+	"push r18 \n\t" \
+	"push r19 \n\t" \
+	"push r20 \n\t" \
+	"push r21 \n\t" \
+	"push r22 \n\t" \
+	"push r23 \n\t" \
+	"push r24 \n\t" \
+	"push r25 \n\t" \
+	"push r26 \n\t" \
+	"push r27 \n\t" \
+	"push r28 \n\t" \
+	"push r29 \n\t" \
+	"push r30 \n\t" \
+	"push r31 \n\t" \
+	_x_load_cmds \
+	"in r0, __SP_L__ \n\t" \
+	"st X+, r0 \n\t" \
+	"in r0, __SP_H__ \n\t" \
+	"st X, r0 \n\t"::)
+
+
+
+///Loads the stack pointer from the start of the X loaded context and pops the program context pushed by _ASM_PUSH_CONTEXT, leaving the return address on top
+#define _ASM_POP_CONTEXT_CMDS(_x_load_cmds) \
+	_x_load_cmds \
+	"ld r28, X+ \n\t" \
+	"ld r29, X \n\t" \
+	"out __SP_L__, r28 \n\t" \
+	"out __SP_H__, r29 \n\t" \
+	"pop r31 \n\t" \
+	"pop r30 \n\t" \
+	"pop r29 \n\t" \
+	"pop r28 \n\t" \
+	"pop r27 \n\t" \
+	"pop r26 \n\t" \
+	"pop r25 \n\t" \
+	"pop r24 \n\t" \
+	"pop r23 \n\t" \
+	"pop r22 \n\t" \
+	"pop r21 \n\t" \
+	"pop r20 \n\t" \
+	"pop r19 \n\t" \
+	"pop r18 \n\t" \
+	"pop r17 \n\t" \
+	"pop r16 \n\t" \
+	"pop r15 \n\t" \
+	"pop r14 \n\t" \
+	"pop r13 \n\t" \
+	"pop r12 \n\t" \
+	"pop r11 \n\t" \
+	"pop r10 \n\t" \
+	"pop r9 \n\t" \
+	"pop r8 \n\t" \
+	"pop r7 \n\t" \
+	"pop r6 \n\t" \
+	"pop r5 \n\t" \
+	"pop r4 \n\t" \
+	"pop r3 \n\t" \
+	"pop r2 \n\t" \
+	"pop r1 \n\t" \
+	"pop r0 \n\t" \
+	"out __SREG__, r0 \n\t" \
+	"pop r0 \n\t"
+
+///Runs _ASM_POP_CONTEXT_CMDS as its own asm block
+#define _ASM_POP_CONTEXT(_x_load_cmds) asm volatile( _ASM_POP_CONTEXT_CMDS(_x_load_cmds) ::)
+
+
+
+///Saves only the registers a call has to keep, r2 to r17, r28 and r29, with the return address and stack pointer. \n
+///For switching out from a call, where the rest are the caller's to lose. See _ASM_SAVE_CONTEXT for the layout
+#define _ASM_SAVE_PARTIAL_CONTEXT(_z_load_cmds) \
+asm volatile(  \
+	_z_load_cmds \
+	"std Z+3, r2 \n\t" \
+	"std Z+4, r3 \n\t" \
+	"std Z+5, r4 \n\t" \
+	"std Z+6, r5 \n\t" \
+	"std Z+7, r6 \n\t" \
+	"std Z+8, r7 \n\t" \
+	"std Z+9, r8 \n\t" \
+	"std Z+10, r9 \n\t" \
+	"std Z+11, r10 \n\t" \
+	"std Z+12, r11 \n\t" \
+	"std Z+13, r12 \n\t" \
+	"std Z+14, r13 \n\t" \
+	"std Z+15, r14 \n\t" \
+	"std Z+16, r15 \n\t" \
+	"std Z+17, r16 \n\t" \
+	"std Z+18, r17 \n\t" \
+	"std Z+29, r28 \n\t" \
+	"std Z+30, r29 \n\t" \
+	"pop r0 \n\t" \
+	"std Z+CONTEXT_OFFSET_PC_H, r0 \n\t" \
+	"pop r0 \n\t" \
+	"std Z+CONTEXT_OFFSET_PC_L, r0 \n\t" \
+	"in r0, __SP_L__ \n\t" \
+	"std Z+CONTEXT_OFFSET_SP_L, r0 \n\t" \
+	"in r0, __SP_H__ \n\t" \
+	"std Z+CONTEXT_OFFSET_SP_H, r0 \n\t"::)
+
+
+
+///Restores a context saved by _ASM_SAVE_PARTIAL_CONTEXT, leaving the return address on top of its stack
+#define _ASM_RESTORE_PARTIAL_CONTEXT_CMDS(_z_load_cmds) \
+	_z_load_cmds \
+	"ldd r0, Z+CONTEXT_OFFSET_SP_L \n\t" \
+	"out __SP_L__, r0 \n\t" \
+	"ldd r0, Z+CONTEXT_OFFSET_SP_H \n\t" \
+	"out __SP_H__, r0 \n\t" \
+	"ldd r0, Z+CONTEXT_OFFSET_PC_L \n\t" \
+	"push r0 \n\t" \
+	"ldd r0, Z+CONTEXT_OFFSET_PC_H \n\t" \
+	"push r0 \n\t" \
+	"ldd r2, Z+3 \n\t" \
+	"ldd r3, Z+4 \n\t" \
+	"ldd r4, Z+5 \n\t" \
+	"ldd r5, Z+6 \n\t" \
+	"ldd r6, Z+7 \n\t" \
+	"ldd r7, Z+8 \n\t" \
+	"ldd r8, Z+9 \n\t" \
+	"ldd r9, Z+10 \n\t" \
+	"ldd r10, Z+11 \n\t" \
+	"ldd r11, Z+12 \n\t" \
+	"ldd r12, Z+13 \n\t" \
+	"ldd r13, Z+14 \n\t" \
+	"ldd r14, Z+15 \n\t" \
+	"ldd r15, Z+16 \n\t" \
+	"ldd r16, Z+17 \n\t" \
+	"ldd r17, Z+18 \n\t" \
+	"ldd r28, Z+29 \n\t" \
+	"ldd r29, Z+30 \n\t"
+
+///Runs _ASM_RESTORE_PARTIAL_CONTEXT_CMDS as its own asm block
+#define _ASM_RESTORE_PARTIAL_CONTEXT(_z_load_cmds) asm volatile( _ASM_RESTORE_PARTIAL_CONTEXT_CMDS(_z_load_cmds) ::)
+
+
+
+///Pushes only the registers a call has to keep, r2 to r17, r28 and r29, under the return address and saves the stack pointer at the start of the X loaded context
+#define _ASM_PUSH_PARTIAL_CONTEXT(_x_load_cmds) \
+asm volatile(  \
+	"push r2 \n\t" \
+	"push r3 \n\t" \
+	"push r4 \n\t" \
+	"push r5 \n\t" \
+	"push r6 \n\t" \
+	"push r7 \n\t" \
+	"push r8 \n\t" \
+	"push r9 \n\t" \
+	"push r10 \n\t" \
+	"push r11 \n\t" \
+	"push r12 \n\t" \
+	"push r13 \n\t" \
+	"push r14 \n\t" \
+	"push r15 \n\t" \
+	"push r16 \n\t" \
+	"push r17 \n\t" \
+	"push r28 \n\t" \
+	"push r29 \n\t" \
+	_x_load_cmds \
+	"in r0, __SP_L__ \n\t" \
+	"st X+, r0 \n\t" \
+	"in r0, __SP_H__ \n\t" \
+	"st X, r0 \n\t"::)
 
 
 
+///Loads the stack pointer from the start of the X loaded context and pops the registers pushed by _ASM_PUSH_PARTIAL_CONTEXT, leaving the return address on top
+#define _ASM_POP_PARTIAL_CONTEXT_CMDS(_x_load_cmds) \
+	_x_load_cmds \
+	"ld r28, X+ \n\t" \
+	"ld r29, X \n\t" \
+	"out __SP_L__, r28 \n\t" \
+	"out __SP_H__, r29 \n\t" \
+	"pop r29 \n\t" \
+	"pop r28 \n\t" \
+	"pop r17 \n\t" \
+	"pop r16 \n\t" \
+	"pop r15 \n\t" \
+	"pop r14 \n\t" \
+	"pop r13 \n\t" \
+	"pop r12 \n\t" \
+	"pop r11 \n\t" \
+	"pop r10 \n\t" \
+	"pop r9 \n\t" \
+	"pop r8 \n\t" \
+	"pop r7 \n\t" \
+	"pop r6 \n\t" \
+	"pop r5 \n\t" \
+	"pop r4 \n\t" \
+	"pop r3 \n\t" \
+	"pop r2 \n\t"
+
+///Runs _ASM_POP_PARTIAL_CONTEXT_CMDS as its own asm block
+#define _ASM_POP_PARTIAL_CONTEXT(_x_load_cmds) asm volatile( _ASM_POP_PARTIAL_CONTEXT_CMDS(_x_load_cmds) ::)
+
+
+
+///Restores the Z loaded context with the full or the partial commands, picked by the flag byte at _offset, up to 63, into it. \n
+///One asm block, so nothing runs between the test and the restore. The partial path is the branch target since the full commands stay in brne range
+#define _ASM_RESTORE_FLAGGED_CONTEXT(_z_load_cmds, _full_cmds, _partial_cmds, _offset) \
+asm volatile(  \
+	_z_load_cmds \
+	"ldd r0, Z+%0 \n\t" \
+	"tst r0 \n\t" \
+	"brne 1f \n\t" \
+	_full_cmds \
+	"rjmp 2f \n\t" \
+	"1: \n\t" \
+	_partial_cmds \
+	"2: \n\t" :: "I" (_offset))
+
+
+
+#if TASK_CONTEXT_ON_STACK
+
+///Saves only the call saved registers of a global pointers context, pushed on the current stack
+#define ASM_SAVE_GLOBAL_PTR_PARTIAL_CONTEXT(_ptr) \
+_ASM_PUSH_PARTIAL_CONTEXT( "lds XL, " #_ptr " \n\t" "lds XH, " #_ptr "+1 \n\t")
+
+
+
+///Restores a global pointers context saved by ASM_SAVE_GLOBAL_PTR_PARTIAL_CONTEXT
+#define ASM_RESTORE_GLOBAL_PTR_PARTIAL_CONTEXT(_ptr) \
+_ASM_POP_PARTIAL_CONTEXT( "lds XL, " #_ptr " \n\t" "lds XH, " #_ptr "+1 \n\t")
+
+
+
+///Saves a global pointers context, pushed on the current stack. The stack pointer is the first thing in the context
+#define ASM_SAVE_GLOBAL_PTR_CONTEXT(_ptr) \
+_ASM_PUSH_CONTEXT( "lds XL, " #_ptr " \n\t" "lds XH, " #_ptr "+1 \n\t")
+
+
+
+///Restores a global pointers context, popped from its stack
+#define ASM_RESTORE_GLOBAL_PTR_CONTEXT(_ptr) \
+_ASM_POP_CONTEXT( "lds XL, " #_ptr " \n\t" "lds XH, " #_ptr "+1 \n\t")
+
+
+
+///Restores a global pointers context, partial if the flag byte at _offset into it is set and full if not
+#define ASM_RESTORE_GLOBAL_PTR_FLAGGED_CONTEXT(_ptr, _offset) \
+_ASM_RESTORE_FLAGGED_CONTEXT( "lds ZL, " #_ptr " \n\t" "lds ZH, " #_ptr "+1 \n\t", \
+	_ASM_POP_CONTEXT_CMDS("movw r26, r30 \n\t"), _ASM_POP_PARTIAL_CONTEXT_CMDS("movw r26, r30 \n\t"), _offset)
+
+#else
+
+///Saves only the call saved registers of a global pointers context
+#define ASM_SAVE_GLOBAL_PTR_PARTIAL_CONTEXT(_ptr) \
+_ASM_SAVE_PARTIAL_CONTEXT( "lds ZL, " #_ptr " \n\t" "lds ZH, " #_ptr "+1 \n\t")
+
+
+
+///Restores a global pointers context saved by ASM_SAVE_GLOBAL_PTR_PARTIAL_CONTEXT
+#define ASM_RESTORE_GLOBAL_PTR_PARTIAL_CONTEXT(_ptr) \
+_ASM_RESTORE_PARTIAL_CONTEXT( "lds ZL, " #_ptr " \n\t" "lds ZH, " #_ptr "+1 \n\t")
+
 
 
 ///Restores a global pointers context. See naked functions for comments.
@@ -208,6 +511,35 @@ _ASM_RESTORE_CONTEXT( "lds ZL, " #_ptr " \n\t" "lds ZH, " #_ptr " + 1 \n\t")
 
 
 
+///Restores a global pointers context, partial if the flag byte at _offset into it is set and full if not
+#define ASM_RESTORE_GLOBAL_PTR_FLAGGED_CONTEXT(_ptr, _offset) \
+_ASM_RESTORE_FLAGGED_CONTEXT( "lds ZL, " #_ptr " \n\t" "lds ZH, " #_ptr "+1 \n\t", \
+	_ASM_RESTORE_CONTEXT_CMDS(""), _ASM_RESTORE_PARTIAL_CONTEXT_CMDS(""), _offset)
+
+#endif
+
+
+
+///Stores a constant byte at an offset, up to 63, into what a global pointer points to. Uses r24 and Z, so only use while the context is saved
+#define ASM_STORE_GLOBAL_PTR_BYTE(_ptr, _offset, _value) \
+asm volatile(  \
+	"lds ZL, " #_ptr " \n\t" \
+	"lds ZH, " #_ptr "+1 \n\t" \
+	"ldi r24, %1 \n\t" \
+	"std Z+%0, r24 \n\t" :: "I" (_offset), "M" ((uint8_t)(_value)) : "r24", "r30", "r31", "memory")
+
+
+
+///Stores a constant byte to a global. Uses r24, so only use while the context is saved
+#define ASM_STORE_GLOBAL_BYTE(_var, _value) \
+asm volatile(  \
+	"ldi r24, %0 \n\t" \
+	"sts " #_var ", r24 \n\t" :: "M" ((uint8_t)(_value)) : "r24", "memory")
+
+
+
+#if !TASK_CONTEXT_ON_STACK
+
 /**
  * \brief Saves program context into the passed Context
  * \param taskContext The context structure to save to
@@ -745,6 +1077,8 @@ __attribute__((naked, unused)) static void RestoreContext(volatile TaskContext_t
 
 //----------------------------------------------------------------------------------------------------
 
+#endif
+
 
 
 #endif /* PREEMPTIVETASKSCHEDULERASM_H_ */
\ No newline at end of file
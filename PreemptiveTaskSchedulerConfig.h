@@ -29,11 +29,29 @@ extern "C" {
 #define MAX_TASKS						11
 #endif
 
+#if MAX_TASKS > 31
+#error MAX_TASKS must be 31 or less, every task control slot needs a bit in the task bitmaps
+#endif
+
+///The amount of priority bands used by the ready bitmaps. Priorities at or above the top band share it, though strict priority still runs the highest of them first
+#ifndef TASK_PRIORITY_BANDS
+#define TASK_PRIORITY_BANDS				8
+#endif
+
+#if TASK_PRIORITY_BANDS > 8 || TASK_PRIORITY_BANDS < 1
+#error TASK_PRIORITY_BANDS must be between 1 and 8
+#endif
+
 ///The amount of registers in the task general purpose file register
 #ifndef TASK_REGISTERS
 #define TASK_REGISTERS					32
 #endif
 
+///Pushes each task's context onto its own stack on a switch, keeping only the stack pointer in its task control, instead of storing it in the task control
+#ifndef TASK_CONTEXT_ON_STACK
+#define TASK_CONTEXT_ON_STACK			0
+#endif
+
 ///The amount of ticks for our interrupt scheduler
 #ifndef TASK_INTERRUPT_TICKS
 #define	TASK_INTERRUPT_TICKS			0x2f0
@@ -45,11 +63,102 @@ extern "C" {
 #define SCHEDULER_INT_VECTOR			TIMER3_OVF_vect
 #endif
 
+///Enables tickless idle. While only one task can run, the scheduler timer is stretched to the next wake instead of firing every slice
+#ifndef TASK_TICKLESS_IDLE
+#define TASK_TICKLESS_IDLE				0
+#endif
+
+///Sleeps the processor in idle mode until the next interrupt while the main task waits with nothing else to run. 0 spins through the switch instead
+#ifndef TASK_IDLE_SLEEP
+#define TASK_IDLE_SLEEP					1
+#endif
+
+///Keeps a period and deadline in each task control, for periodic tasks, TASK_SCHEDULE_EDF and TASK_SCHEDULE_RATE_MONOTONIC. 0 leaves them out
+#ifndef TASK_DEADLINES
+#define TASK_DEADLINES					1
+#endif
+
+///Keeps a stride and pass in each task control, for TASK_SCHEDULE_STRIDE and SetTaskWeight. 0 leaves them out
+#ifndef TASK_STRIDE_SCHEDULING
+#define TASK_STRIDE_SCHEDULING			1
+#endif
+
+///Keeps the bits waited on in each task control, for event groups. 0 leaves them out
+#ifndef TASK_EVENT_GROUPS
+#define TASK_EVENT_GROUPS				1
+#endif
+
+///Keeps a list of joined tasks and an exit value in each task control, for TaskJoin and TaskExit. 0 leaves them out, and KillTask yields until the task is gone instead
+#ifndef TASK_JOIN
+#define TASK_JOIN						1
+#endif
+
+///Release jitter allowed for in the periodic task admission check. Releases land on scheduler ticks, so a tick covers it
+#ifndef TASK_RELEASE_JITTER_TICKS
+#define TASK_RELEASE_JITTER_TICKS		1
+#endif
+
+///The stride of a task with a weight of 1 under TASK_SCHEDULE_STRIDE. Must keep strides under 32768 so 16 bit pass values compare across wrap
+#ifndef TASK_STRIDE_ONE
+#define TASK_STRIDE_ONE					4096
+#endif
+
+#if TASK_STRIDE_ONE > 32767 || TASK_STRIDE_ONE < 255
+#error TASK_STRIDE_ONE must be between 255 and 32767
+#endif
+
+///Bits per level of the timeout timer wheel, each level has 2 to the power of this many slots. 0 uses one queue ordered by deadline instead
+#ifndef TASK_TIMER_WHEEL_BITS
+#define TASK_TIMER_WHEEL_BITS			4
+#endif
+
+///The amount of levels in the timeout timer wheel. Deadlines past the span of the wheel are parked in the top level until they are in range
+#ifndef TASK_TIMER_WHEEL_LEVELS
+#define TASK_TIMER_WHEEL_LEVELS			4
+#endif
+
+#if TASK_TIMER_WHEEL_BITS > 4
+#error TASK_TIMER_WHEEL_BITS must be 4 or less
+#endif
+
+#if TASK_TIMER_WHEEL_BITS > 0 && ((TASK_TIMER_WHEEL_BITS * TASK_TIMER_WHEEL_LEVELS) > 32 || TASK_TIMER_WHEEL_LEVELS < 1 || TASK_TIMER_WHEEL_LEVELS > 8)
+#error The timer wheel must have between 1 and 8 levels and span 32 bits or less
+#endif
+
+///The amount of flag bits in each event group, 8 or 16
+#ifndef TASK_EVENT_BITS
+#define TASK_EVENT_BITS					8
+#endif
+
+#if TASK_EVENT_BITS != 8 && TASK_EVENT_BITS != 16
+#error TASK_EVENT_BITS must be 8 or 16
+#endif
+
+///The amount of work items interrupts can leave for the deferred worker task, a power of two up to 128
+#ifndef TASK_DEFERRED_QUEUE_SIZE
+#define TASK_DEFERRED_QUEUE_SIZE		8
+#endif
+
 ///Our task stack size
 #ifndef TASK_STACK_SIZE
 #define TASK_STACK_SIZE					64
 #endif
 
+///Bytes in the arena task stacks are carved from, placed in .noinit so the linker checks it fits in RAM. 0 carves fixed TASK_STACK_SIZE stacks down from RAMEND instead
+#ifndef TASK_STACK_ARENA_SIZE
+#define TASK_STACK_ARENA_SIZE			0
+#endif
+
+///Paints task stacks when they're given out and checks them for overflow on each switch, for GetTaskStackHighWater and TaskStackOverflow
+#ifndef TASK_STACK_CHECK
+#define TASK_STACK_CHECK				0
+#endif
+
+///The byte task stacks are painted with. The lowest byte of each stack is checked for it on each switch
+#ifndef TASK_STACK_PAINT
+#define TASK_STACK_PAINT				0xA5
+#endif
+
 ///Main keyword for interrupts (ex. ISR for AVR)
 #ifndef SCHEDULER_INTERRUPT_KEYWORD
 #define SCHEDULER_INTERRUPT_KEYWORD		ISR
@@ -72,6 +181,12 @@ extern "C" {
 		#ifndef _SCHEDULER_LOAD_ISR_REG
 		#define _SCHEDULER_LOAD_ISR_REG()	TCNT3 = 0xffff-TASK_INTERRUPT_TICKS
 		#endif
+		
+		#ifndef _SCHEDULER_LOAD_ISR_COUNTS
+		#define _SCHEDULER_LOAD_ISR_COUNTS(_c)	TCNT3 = 0xffff-(uint16_t)(_c)
+		#define _SCHEDULER_ISR_COUNTS_LEFT()	(uint16_t)(0xffff-TCNT3)
+		#define TASK_TICKLESS_MAX_SLICES		(0xffff/TASK_INTERRUPT_TICKS)
+		#endif
 	
 		#ifndef _SCHEDULER_EN_ISR
 		#define _SCHEDULER_EN_ISR()			TIMSK3 |= (1 << TOIE3)
@@ -90,6 +205,12 @@ extern "C" {
 		#ifndef _SCHEDULER_LOAD_ISR_REG
 		#define _SCHEDULER_LOAD_ISR_REG()	TCNT2 = 0xff-TASK_INTERRUPT_TICKS
 		#endif
+		
+		#ifndef _SCHEDULER_LOAD_ISR_COUNTS
+		#define _SCHEDULER_LOAD_ISR_COUNTS(_c)	TCNT2 = 0xff-(uint8_t)(_c)
+		#define _SCHEDULER_ISR_COUNTS_LEFT()	(uint8_t)(0xff-TCNT2)
+		#define TASK_TICKLESS_MAX_SLICES		(0xff/TASK_INTERRUPT_TICKS)
+		#endif
 	
 		#ifndef _SCHEDULER_EN_ISR
 		#define _SCHEDULER_EN_ISR()			TIMSK2 |= (1 << TOIE2)
@@ -108,6 +229,12 @@ extern "C" {
 		#ifndef _SCHEDULER_LOAD_ISR_REG
 		#define _SCHEDULER_LOAD_ISR_REG()	TCNT1 = 0xffff-TASK_INTERRUPT_TICKS
 		#endif
+		
+		#ifndef _SCHEDULER_LOAD_ISR_COUNTS
+		#define _SCHEDULER_LOAD_ISR_COUNTS(_c)	TCNT1 = 0xffff-(uint16_t)(_c)
+		#define _SCHEDULER_ISR_COUNTS_LEFT()	(uint16_t)(0xffff-TCNT1)
+		#define TASK_TICKLESS_MAX_SLICES		(0xffff/TASK_INTERRUPT_TICKS)
+		#endif
 	
 		#ifndef _SCHEDULER_EN_ISR
 		#define _SCHEDULER_EN_ISR()			TIMSK1 |= (1 << TOIE1)
@@ -126,6 +253,12 @@ extern "C" {
 		#ifndef _SCHEDULER_LOAD_ISR_REG
 		#define _SCHEDULER_LOAD_ISR_REG()	TCNT0 = 0xff-TASK_INTERRUPT_TICKS
 		#endif
+		
+		#ifndef _SCHEDULER_LOAD_ISR_COUNTS
+		#define _SCHEDULER_LOAD_ISR_COUNTS(_c)	TCNT0 = 0xff-(uint8_t)(_c)
+		#define _SCHEDULER_ISR_COUNTS_LEFT()	(uint8_t)(0xff-TCNT0)
+		#define TASK_TICKLESS_MAX_SLICES		(0xff/TASK_INTERRUPT_TICKS)
+		#endif
 	
 		#ifndef _SCHEDULER_EN_ISR
 		#define _SCHEDULER_EN_ISR()			TIMSK0 |= (1 << TOIE0)
@@ -171,6 +304,33 @@ extern "C" {
 
 
 
+#ifndef _SCHEDULER_LOAD_ISR_SLICES
+
+#if defined(_SCHEDULER_LOAD_ISR_COUNTS) && defined(_SCHEDULER_ISR_COUNTS_LEFT)
+
+///Loads the scheduler interrupt to fire after the passed amount of slices
+#define _SCHEDULER_LOAD_ISR_SLICES(_n)	_SCHEDULER_LOAD_ISR_COUNTS((_n)*TASK_INTERRUPT_TICKS)
+
+#else
+
+///Loads the scheduler interrupt to fire after the passed amount of slices. Without a timer specific version, only one slice is possible
+#define _SCHEDULER_LOAD_ISR_SLICES(_n)	_SCHEDULER_LOAD_ISR_REG()
+
+#undef TASK_TICKLESS_MAX_SLICES
+
+#endif
+
+#endif
+
+#ifndef TASK_TICKLESS_MAX_SLICES
+
+///The most slices the scheduler interrupt can be stretched over in tickless idle
+#define TASK_TICKLESS_MAX_SLICES		1
+
+#endif
+
+
+
 #ifndef _TASK_STACK_START_ADDRESS
 
 	#ifndef RAMEND
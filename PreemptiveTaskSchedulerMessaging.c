@@ -0,0 +1,402 @@
+/**
+ * \file PreemptiveTaskSchedulerMessaging.c
+ * \author: Tim Robbins
+ * \brief Source file for passing messages between tasks in preemptive task scheduling and concurrent functionality. \n
+ *
+ * Queues hold a fixed amount of fixed size messages, copied in and out. A task sending to a full queue or receiving from an empty one \n
+ * is blocked until the other side makes room or a message, so it takes no time from the processor while it waits. \n
+ * For larger messages, a queue with an item size of a pointer can pass buffers taken from a pool, handing over the buffer instead of copying it. \n
+ * Interrupts can also defer work, a function and its argument, to a worker task that runs it with interrupts on.
+ */
+#include "PreemptiveTaskScheduler.h"
+#include "PreemptiveTaskSchedulerRing.h"
+
+#include <string.h>
+
+
+
+TASK_RING_DEFINE(_DeferredRing, TaskDeferredWork_t, TASK_DEFERRED_QUEUE_SIZE)
+
+///Given when deferred work comes in while the worker has none
+static TaskSemaphore_t m_DeferredReady = TASK_SEMAPHORE_INIT(0, 1, TASK_WAIT_PRIORITY);
+
+///The work deferred to the worker task, in order
+static _DeferredRing_t m_DeferredRing = { 0, 0, 1, &m_DeferredReady };
+
+///The most work items ever waiting at once
+static uint8_t m_DeferredDepthMax;
+
+///The amount of work items dropped because the queue was full
+static uint16_t m_DeferredOverflows;
+
+
+
+/**
+* \brief Sends or receives a message, blocking in priority order until there is room or a message, or the timeout runs out
+* \param queue The queue
+* \param item The message to copy in, or the place to copy it out to
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until done
+* \param sending true to send, false to receive
+* \ret 1 if done, 0 if the timeout ran out
+*/
+static uint8_t _QueueTransfer(TaskQueue_t *queue, void *item, TaskTimeout_t timeout, bool sending)
+{
+	const TaskIndiceType_t index = _GetCurrentTaskIndex();
+	TaskIndiceType_t *waitHead = (sending) ? &queue->sendHead : &queue->receiveHead;
+	TaskIndiceType_t *otherHead = (sending) ? &queue->receiveHead : &queue->sendHead;
+	TaskTick_t deadline;
+	uint8_t done = 0;
+	bool blocked;
+	
+	TASK_CRITICAL_SECTION ( deadline = _TimerTicks() + timeout; );
+	
+	//Until we're done or out of time...
+	do
+	{
+		blocked = false;
+		
+		TASK_CRITICAL_SECTION (
+		
+			//If there's room to send or a message to receive, copy it and wake the first waiting on the other side
+			if((sending) ? (queue->count < queue->capacity) : (queue->count > 0))
+			{
+				if(sending)
+				{
+					//Summed wide, since past a capacity of 128 it can run over a byte
+					uint16_t slot = (uint16_t)queue->front + queue->count;
+					
+					if(slot >= queue->capacity)
+					{
+						slot -= queue->capacity;
+					}
+					
+					memcpy(queue->buffer + slot * queue->itemSize, item, queue->itemSize);
+					queue->count++;
+				}
+				else
+				{
+					memcpy(item, queue->buffer + (uint16_t)queue->front * queue->itemSize, queue->itemSize);
+					queue->count--;
+					
+					if(++queue->front >= queue->capacity)
+					{
+						queue->front = 0;
+					}
+				}
+				
+				const TaskIndiceType_t next = _WaitListPop(otherHead);
+				
+				if(next >= 0)
+				{
+					_TaskWake(next);
+				}
+				
+				done = 1;
+			}
+			//Else if we can wait, block for whatever is left of our timeout
+			else if(timeout != 0 && index >= 0)
+			{
+				const int32_t remaining = (int32_t)(deadline - _TimerTicks());
+				
+				if(timeout < 0 || remaining > 0)
+				{
+					_TaskBlockFor(index, waitHead, TASK_WAIT_PRIORITY, (timeout < 0) ? TASK_WAIT_FOREVER : (TaskTimeout_t)remaining);
+					blocked = true;
+				}
+			}
+		);
+		
+		//Being woken only means there's room or a message, someone else may take it first, so try again
+	} while(blocked && _TaskWaitWoken(index));
+	
+	return done;
+}
+
+
+
+/**
+* \brief Initializes the queue as empty with no waiters
+* \param queue The queue
+* \param storage Space for the messages, at least the item size times the capacity
+* \param itemSize The bytes in each message
+* \param capacity How many messages the queue holds at most
+*/
+void QueueInit(TaskQueue_t *queue, void *storage, uint8_t itemSize, uint8_t capacity)
+{
+	TASK_CRITICAL_SECTION (
+		queue->buffer = (uint8_t *)storage;
+		queue->itemSize = itemSize;
+		queue->capacity = capacity;
+		queue->count = 0;
+		queue->front = 0;
+		queue->sendHead = -1;
+		queue->receiveHead = -1;
+	);
+}
+
+
+
+/**
+* \brief Copies the message onto the back of the queue, blocking while it is full
+* \param queue The queue
+* \param item The message, the queue's item size in bytes
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until there is room
+* \ret 1 if sent, 0 if the timeout ran out
+*/
+uint8_t QueueSend(TaskQueue_t *queue, const void *item, TaskTimeout_t timeout)
+{
+	return _QueueTransfer(queue, (void *)item, timeout, true);
+}
+
+
+
+/**
+* \brief Copies the message off the front of the queue, blocking while it is empty
+* \param queue The queue
+* \param item Where to copy the message, the queue's item size in bytes
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until there is a message
+* \ret 1 if received, 0 if the timeout ran out
+*/
+uint8_t QueueReceive(TaskQueue_t *queue, void *item, TaskTimeout_t timeout)
+{
+	return _QueueTransfer(queue, item, timeout, false);
+}
+
+
+
+/**
+* \brief Sends the buffer through a queue with an item size of a pointer, handing it to the receiver without copying it. \n
+* The buffer belongs to the receiver once sent, who frees it back to its pool
+* \param queue The queue
+* \param buffer The buffer, usually from PoolAlloc
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until there is room
+* \ret 1 if sent, 0 if the timeout ran out and the buffer is still ours
+*/
+uint8_t QueueSendBuffer(TaskQueue_t *queue, void *buffer, TaskTimeout_t timeout)
+{
+	return _QueueTransfer(queue, &buffer, timeout, true);
+}
+
+
+
+/**
+* \brief Receives a buffer sent by QueueSendBuffer, taking it over
+* \param queue The queue
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until there is a buffer
+* \ret The buffer, 0 if the timeout ran out
+*/
+void* QueueReceiveBuffer(TaskQueue_t *queue, TaskTimeout_t timeout)
+{
+	void *buffer = 0;
+	
+	_QueueTransfer(queue, &buffer, timeout, false);
+	
+	return buffer;
+}
+
+
+
+/**
+* \brief Returns how many messages are in the queue
+* \param queue The queue
+*/
+uint8_t QueueGetCount(TaskQueue_t *queue)
+{
+	uint8_t count;
+	
+	TASK_CRITICAL_SECTION ( count = queue->count; );
+	
+	return count;
+}
+
+
+
+/**
+* \brief Initializes the pool with every block free
+* \param pool The pool
+* \param storage Space for the blocks, at least the block size times the block count
+* \param blockSize The bytes in each block, at least the size of a pointer
+* \param blockCount How many blocks, up to 127
+*/
+void PoolInit(TaskPool_t *pool, void *storage, uint8_t blockSize, uint8_t blockCount)
+{
+	uint8_t *block = (uint8_t *)storage;
+	
+	TASK_CRITICAL_SECTION (
+	
+		pool->freeList = 0;
+		
+		//Link every block into the free list, each free block holds the next
+		for(uint8_t i = 0; i < blockCount; i++, block += blockSize)
+		{
+			*(void **)block = pool->freeList;
+			pool->freeList = block;
+		}
+	);
+	
+	SemaphoreInit(&pool->available, blockCount, blockCount, TASK_WAIT_PRIORITY);
+}
+
+
+
+/**
+* \brief Takes a free block from the pool, blocking while there are none
+* \param pool The pool
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until one is freed
+* \ret The block, 0 if the timeout ran out
+*/
+void* PoolAlloc(TaskPool_t *pool, TaskTimeout_t timeout)
+{
+	void *block = 0;
+	
+	//Our take on the count reserves us a block
+	if(SemaphoreTakeTimeout(&pool->available, timeout))
+	{
+		TASK_CRITICAL_SECTION (
+			block = pool->freeList;
+			pool->freeList = *(void **)block;
+		);
+	}
+	
+	return block;
+}
+
+
+
+/**
+* \brief Gives the block back to the pool, waking the first task waiting for one
+* \param pool The pool
+* \param block The block from PoolAlloc
+*/
+void PoolFree(TaskPool_t *pool, void *block)
+{
+	TASK_CRITICAL_SECTION (
+		*(void **)block = pool->freeList;
+		pool->freeList = block;
+	);
+	
+	SemaphoreGive(&pool->available);
+}
+
+
+
+/**
+* \brief The deferred worker task. Runs each work item in the order deferred, blocking while there are none
+*
+*/
+static void _DeferredWorker(void)
+{
+	TaskDeferredWork_t work;
+	
+	for(;;)
+	{
+		_DeferredRingWait(&m_DeferredRing);
+		
+		while(_DeferredRingGet(&m_DeferredRing, &work))
+		{
+			work.func(work.arg);
+		}
+	}
+}
+
+
+
+/**
+* \brief Attaches the deferred worker task, which runs the work deferred by interrupts
+* \param id The position to attach at as well as the tasks ID
+* \param priority The priority to run work at, usually above everything it was deferred for
+* \param stackSize The bytes the worker's stack needs, enough for the deepest deferred function
+* \return The next id/index position, the same id if the stack doesn't fit
+*/
+TaskIndiceType_t AttachDeferredWorker(TaskIndiceType_t id, TaskPriorityLevel_t priority, uint16_t stackSize)
+{
+	const TaskIndiceType_t next = AttachTaskStack((void *)_DeferredWorker, id, stackSize);
+	
+	//If we attached, set our priority
+	if(next > id)
+	{
+		SetTaskPriority(id, priority);
+	}
+	
+	return next;
+}
+
+
+
+/**
+* \brief Leaves the work for the deferred worker task from an interrupt, in constant time. Interrupts must be off, as they are in an ISR
+* \param func The function to run
+* \param arg What to pass it
+* \ret 1 if deferred, 0 if the queue was full and the work was dropped
+*/
+uint8_t DeferWorkFromISR(void (*func)(void *arg), void *arg)
+{
+	const TaskDeferredWork_t work = { func, arg };
+	
+	//If we're full, count the drop
+	if(!_DeferredRingPut(&m_DeferredRing, work))
+	{
+		if(m_DeferredOverflows < UINT16_MAX)
+		{
+			m_DeferredOverflows++;
+		}
+		
+		return 0;
+	}
+	
+	//Keep track of the deepest we've been
+	if(_DeferredRingCount(&m_DeferredRing) > m_DeferredDepthMax)
+	{
+		m_DeferredDepthMax = _DeferredRingCount(&m_DeferredRing);
+	}
+	
+	return 1;
+}
+
+
+
+/**
+* \brief Leaves the work for the deferred worker task from a task
+* \param func The function to run
+* \param arg What to pass it
+* \ret 1 if deferred, 0 if the queue was full and the work was dropped
+*/
+uint8_t DeferWork(void (*func)(void *arg), void *arg)
+{
+	uint8_t deferred;
+	
+	//Interrupts are the other producers, so keep them out while we put
+	TASK_CRITICAL_SECTION ( deferred = DeferWorkFromISR(func, arg); );
+	
+	return deferred;
+}
+
+
+
+/**
+* \brief Returns the most work items that have been waiting for the deferred worker at once
+*
+*/
+uint8_t GetDeferredWorkDepthMax(void)
+{
+	uint8_t depth;
+	
+	TASK_CRITICAL_SECTION ( depth = m_DeferredDepthMax; );
+	
+	return depth;
+}
+
+
+
+/**
+* \brief Returns the amount of work items dropped because the deferred work queue was full
+*
+*/
+uint16_t GetDeferredWorkOverflows(void)
+{
+	uint16_t overflows;
+	
+	TASK_CRITICAL_SECTION ( overflows = m_DeferredOverflows; );
+	
+	return overflows;
+}
@@ -0,0 +1,185 @@
+/**
+ * \file PreemptiveTaskSchedulerRing.h
+ * \author: Tim Robbins
+ * \brief Single producer, single consumer ring buffers for preemptive task scheduling and concurrent functionality. \n
+ *
+ * TASK_RING_DEFINE(Name, type, size) declares the ring type Name_t and its functions, such as NamePut and NameGet. \n
+ * The size must be a power of two, up to 128. The head is only written by the producer and the tail only by the consumer, \n
+ * and both are single bytes, so one interrupt or task can put while another gets without turning interrupts off. \n
+ * Only one producer and one consumer may use a ring at a time. \n
+ * If the ring is given a semaphore, a put that brings the count up to the threshold gives it, so a consumer blocked in NameWait wakes.
+ */
+#ifndef __PREEMPTIVETASKSCHEDULERRING_H__
+#define __PREEMPTIVETASKSCHEDULERRING_H__	1
+
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#include "PreemptiveTaskScheduler.h"
+
+
+
+/**
+* \brief Gives the semaphore of a ring from wherever we're called, a task or an interrupt
+* \param sem The semaphore, nothing is done if 0
+*/
+static inline void _TaskRingSignal(TaskSemaphore_t *sem)
+{
+	if(sem == 0)
+	{
+		return;
+	}
+	
+	//If interrupts are on we're in a task, else we're in an interrupt or already critical
+	if(SCHEDULER_ASM_INTERRUPTS_ENABLED())
+	{
+		SemaphoreGive(sem);
+	}
+	else
+	{
+		SemaphoreGiveFromISR(sem);
+	}
+}
+
+
+
+#ifdef	__cplusplus
+	#define _TASK_RING_STATIC_ASSERT	static_assert
+#else
+	#define _TASK_RING_STATIC_ASSERT	_Static_assert
+#endif
+
+
+
+///Declares the single producer, single consumer ring type Name_t of the size, a power of two up to 128, holding the type, and its functions
+#define TASK_RING_DEFINE(Name, type, size)																				\
+																														\
+_TASK_RING_STATIC_ASSERT((size) >= 2 && (size) <= 128 && ((size) & ((size) - 1)) == 0, #Name " size must be a power of two up to 128");	\
+																														\
+typedef struct Name##_t																									\
+{																														\
+	/* Free running count of puts, only written by the producer */														\
+	volatile uint8_t head;																								\
+																														\
+	/* Free running count of gets, only written by the consumer */														\
+	volatile uint8_t tail;																								\
+																														\
+	/* The count a put gives the semaphore at, 0 to never */															\
+	uint8_t threshold;																									\
+																														\
+	/* Given when the count comes up to the threshold, 0 if none */														\
+	TaskSemaphore_t *wake;																								\
+																														\
+	/* The items */																										\
+	type buffer[(size)];																								\
+																														\
+} Name##_t;																												\
+																														\
+/** \brief Empties the ring and sets the semaphore its consumer waits on, best made binary with a count of 0, and the count that gives it */	\
+static inline void Name##Init(Name##_t *ring, TaskSemaphore_t *wake, uint8_t threshold)								\
+{																														\
+	ring->head = 0;																										\
+	ring->tail = 0;																										\
+	ring->wake = wake;																									\
+	ring->threshold = threshold;																						\
+}																														\
+																														\
+/** \brief Returns how many items are in the ring */																	\
+static inline uint8_t Name##Count(const Name##_t *ring)																\
+{																														\
+	return (uint8_t)(ring->head - ring->tail);																			\
+}																														\
+																														\
+/** \brief Puts the items in, as many as fit, giving the semaphore if we reach the threshold. Producer only */		\
+static inline uint8_t Name##PutBulk(Name##_t *ring, const type *items, uint8_t amount)									\
+{																														\
+	uint8_t head = ring->head;																							\
+	const uint8_t before = (uint8_t)(head - ring->tail);																\
+	const uint8_t space = (uint8_t)((size) - before);																	\
+																														\
+	if(amount > space)																									\
+	{																													\
+		amount = space;																									\
+	}																													\
+																														\
+	for(uint8_t i = 0; i < amount; i++, head++)																			\
+	{																													\
+		ring->buffer[head & ((size) - 1)] = items[i];																	\
+	}																													\
+																														\
+	/* Only publish once the items are written */																		\
+	SCHEDULER_ASM_MEMORY_BARRIER();																						\
+	ring->head = head;																									\
+																														\
+	/* If we just came up to the threshold, wake the consumer */														\
+	if(ring->threshold > 0 && before < ring->threshold && before + amount >= ring->threshold)							\
+	{																													\
+		_TaskRingSignal(ring->wake);																					\
+	}																													\
+																														\
+	return amount;																										\
+}																														\
+																														\
+/** \brief Puts the item in, returning false if full. Producer only */												\
+static inline bool Name##Put(Name##_t *ring, type item)																\
+{																														\
+	return Name##PutBulk(ring, &item, 1) == 1;																			\
+}																														\
+																														\
+/** \brief Gets up to the amount of items out, returning how many were. Consumer only */							\
+static inline uint8_t Name##GetBulk(Name##_t *ring, type *items, uint8_t amount)										\
+{																														\
+	uint8_t tail = ring->tail;																							\
+	const uint8_t available = (uint8_t)(ring->head - tail);															\
+																														\
+	if(amount > available)																								\
+	{																													\
+		amount = available;																								\
+	}																													\
+																														\
+	/* Only read items the producer has published */																	\
+	SCHEDULER_ASM_MEMORY_BARRIER();																						\
+																														\
+	for(uint8_t i = 0; i < amount; i++, tail++)																			\
+	{																													\
+		items[i] = ring->buffer[tail & ((size) - 1)];																	\
+	}																													\
+																														\
+	/* Only hand the space back once the items are read */																\
+	SCHEDULER_ASM_MEMORY_BARRIER();																						\
+	ring->tail = tail;																									\
+																														\
+	return amount;																										\
+}																														\
+																														\
+/** \brief Gets the item out, returning false if empty. Consumer only */												\
+static inline bool Name##Get(Name##_t *ring, type *item)																\
+{																														\
+	return Name##GetBulk(ring, item, 1) == 1;																			\
+}																														\
+																														\
+/** \brief Blocks the consumer task until the ring holds at least the threshold, or anything if no threshold */		\
+static inline void Name##Wait(Name##_t *ring)																			\
+{																														\
+	const uint8_t wanted = (ring->threshold > 0) ? ring->threshold : 1;												\
+																														\
+	/* A give can be left over from items we already took, so check again after each */								\
+	while(Name##Count(ring) < wanted && ring->wake != 0)																\
+	{																													\
+		SemaphoreTake(ring->wake);																						\
+	}																													\
+}
+
+
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+
+
+#endif /* __PREEMPTIVETASKSCHEDULERRING_H__ */
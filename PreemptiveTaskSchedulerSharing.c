@@ -7,8 +7,8 @@
 
 
 
-///Semaphore value for accessing memory, registers, ex. adc, etc.
-static SemaphoreValueType_t m_semAccessor = 0;
+///Semaphore for accessing memory, registers, ex. adc, etc.
+static TaskSemaphore_t m_semAccessor = TASK_SEMAPHORE_INIT(1, 1, TASK_WAIT_PRIORITY);
 
 
 /**
@@ -18,48 +18,625 @@ static SemaphoreValueType_t m_semAccessor = 0;
 uint8_t OpenSemaphoreRequest(bool waitForAccess)
 {
 	
-	if(waitForAccess == true)
+	return SemaphoreTakeTimeout(&m_semAccessor, (waitForAccess == true) ? TASK_WAIT_FOREVER : 0);
+}
+
+
+
+/**
+* \brief Closes the request for the semaphore accessor
+*
+*/
+uint8_t CloseSemaphoreRequest()
+{
+	return SemaphoreGive(&m_semAccessor);
+}
+
+
+
+/**
+* \brief Takes from the semaphore for the current task, blocking until given or the timeout runs out
+* \param sem The semaphore
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until given
+* \ret 1 if taken, 0 if not
+*/
+static uint8_t _SemaphoreTake(TaskSemaphore_t *sem, TaskTimeout_t timeout)
+{
+	const TaskIndiceType_t index = _GetCurrentTaskIndex();
+	uint8_t taken = 1;
+	bool blocked = false;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//If we have any left, take one
+		if(sem->count > 0)
+		{
+			sem->count--;
+		}
+		//Else if we're not to wait, we didn't get it
+		else if(timeout == 0 || index < 0)
+		{
+			taken = 0;
+		}
+		//Else wait in line to be given it
+		else
+		{
+			_TaskBlockFor(index, &sem->waitHead, sem->order, timeout);
+			blocked = true;
+		}
+	);
+	
+	//A give hands its count straight to us, so being woken means we have it
+	if(blocked)
+	{
+		taken = _TaskWaitWoken(index);
+	}
+	
+	return taken;
+}
+
+
+
+/**
+* \brief Gives to the semaphore, handing it straight to the first waiter if any. Interrupts must be off.
+* \param sem The semaphore
+* \ret 1 if given, 0 if already at its limit
+*/
+static uint8_t _SemaphoreGive(TaskSemaphore_t *sem)
+{
+	const TaskIndiceType_t next = _WaitListPop(&sem->waitHead);
+	
+	//If someone is waiting, wake them with it
+	if(next >= 0)
+	{
+		_TaskWake(next);
+		return 1;
+	}
+	
+	//Else count up, if we can
+	if(sem->count < sem->limit)
+	{
+		sem->count++;
+		return 1;
+	}
+	
+	return 0;
+}
+
+
+
+/**
+* \brief Initializes the semaphore with no waiters
+* \param sem The semaphore
+* \param count How many takes are available to start with
+* \param limit The most the count can be given up to, 1 for a binary semaphore
+* \param order The order waiters are woken in
+*/
+void SemaphoreInit(TaskSemaphore_t *sem, SemaphoreValueType_t count, SemaphoreValueType_t limit, TaskWaitOrder_t order)
+{
+	TASK_CRITICAL_SECTION (
+		sem->count = count;
+		sem->limit = limit;
+		sem->waitHead = -1;
+		sem->order = order;
+	);
+}
+
+
+
+/**
+* \brief Takes from the semaphore for the current task, blocking until it is given if none are left. \n
+* The task is left out of switching until then, so the processor goes to everyone else
+* \param sem The semaphore
+*/
+void SemaphoreTake(TaskSemaphore_t *sem)
+{
+	_SemaphoreTake(sem, TASK_WAIT_FOREVER);
+}
+
+
+
+/**
+* \brief Takes from the semaphore for the current task without waiting
+* \param sem The semaphore
+* \ret 1 if taken, 0 if none were left
+*/
+uint8_t SemaphoreTryTake(TaskSemaphore_t *sem)
+{
+	return _SemaphoreTake(sem, 0);
+}
+
+
+
+/**
+* \brief Takes from the semaphore for the current task, blocking until it is given or the timeout runs out. Uses the task's wake timer
+* \param sem The semaphore
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until given
+* \ret 1 if taken, 0 if the timeout ran out
+*/
+uint8_t SemaphoreTakeTimeout(TaskSemaphore_t *sem, TaskTimeout_t timeout)
+{
+	return _SemaphoreTake(sem, timeout);
+}
+
+
+
+/**
+* \brief Gives to the semaphore from a task, waking the first waiter if any
+* \param sem The semaphore
+* \ret 1 if given, 0 if already at its limit
+*/
+uint8_t SemaphoreGive(TaskSemaphore_t *sem)
+{
+	uint8_t given;
+	
+	TASK_CRITICAL_SECTION ( given = _SemaphoreGive(sem); );
+	
+	return given;
+}
+
+
+
+/**
+* \brief Gives to the semaphore from an interrupt, waking the first waiter if any. Interrupts must be off, as they are in an ISR
+* \param sem The semaphore
+* \ret 1 if given, 0 if already at its limit
+*/
+uint8_t SemaphoreGiveFromISR(TaskSemaphore_t *sem)
+{
+	return _SemaphoreGive(sem);
+}
+
+
+
+/**
+* \brief Returns how many takes the semaphore has available
+* \param sem The semaphore
+*/
+SemaphoreValueType_t SemaphoreGetCount(TaskSemaphore_t *sem)
+{
+	SemaphoreValueType_t count;
+	
+	TASK_CRITICAL_SECTION ( count = sem->count; );
+	
+	return count;
+}
+
+
+
+/**
+* \brief Works out the priority of the task at the index from its own priority and the first waiter on each mutex it holds, \n
+* then carries it on to the owner of the mutex the task is waiting on, and so on down the chain. Interrupts must be off.
+* \param index The task control index
+*/
+void _MutexPropagatePriority(TaskIndiceType_t index)
+{
+	//Follow the chain at most once through every task, in case of a deadlock loop
+	for(TaskIndiceType_t step = 0; step <= MAX_TASKS && index >= 0; step++)
 	{
-		while(m_semAccessor > 0)
+		TaskControl_t *task = _GetTaskControl(index);
+		TaskPriorityLevel_t priority = task->cachedPriority;
+		
+		//Take on the priority of the first waiter on each mutex we hold, if higher
+		for(TaskMutex_t *held = task->heldMutexes; held != 0; held = held->nextHeld)
 		{
-			
+			if(held->waitHead >= 0 && _ReadTaskPriority(held->waitHead) > priority)
+			{
+				priority = _ReadTaskPriority(held->waitHead);
+			}
+		}
+		
+		//If nothing changed, nobody further down the chain changes either
+		if(priority == _ReadTaskPriority(index))
+		{
+			return;
 		}
+		
+		_WriteTaskPriority(index, priority);
+		
+		//If we're not waiting on a mutex, we're done
+		if(task->blockedOn == 0)
+		{
+			return;
+		}
+		
+		//Move to our new place in the wait list and carry on to its owner
+		_WaitListRemove(index);
+		_WaitListInsert(&task->blockedOn->waitHead, index);
+		index = _GetTaskIndex(task->blockedOn->owner);
 	}
-	else
+}
+
+
+
+/**
+* \brief Hands the mutex to the first waiter, or frees it if nobody is waiting. Interrupts must be off.
+* \param mutex The mutex, already unlinked from its old owner
+*/
+static void _MutexHandOff(TaskMutex_t *mutex)
+{
+	const TaskIndiceType_t next = _WaitListPop(&mutex->waitHead);
+	
+	//If nobody is waiting, we're free
+	if(next < 0)
+	{
+		mutex->owner = -1;
+		mutex->count = 0;
+		return;
+	}
+	
+	//Make the waiter our owner and wake it
+	TaskControl_t *task = _GetTaskControl(next);
+	
+	mutex->owner = task->taskID;
+	mutex->count = 1;
+	mutex->nextHeld = task->heldMutexes;
+	task->heldMutexes = mutex;
+	task->blockedOn = 0;
+	_TaskWake(next);
+	
+	//Our new owner takes on the priority of whoever is still waiting
+	_MutexPropagatePriority(next);
+}
+
+
+
+/**
+* \brief Lets go of every mutex the task at the index holds, handing each to its first waiter. Interrupts must be off.
+* \param index The task control index
+*/
+void _MutexAbandon(TaskIndiceType_t index)
+{
+	TaskControl_t *task = _GetTaskControl(index);
+	
+	//For each mutex we hold, unlink and hand it on
+	while(task->heldMutexes != 0)
 	{
-		if(m_semAccessor > 0)
+		TaskMutex_t *mutex = task->heldMutexes;
+		task->heldMutexes = mutex->nextHeld;
+		mutex->nextHeld = 0;
+		_MutexHandOff(mutex);
+	}
+}
+
+
+
+/**
+* \brief Initializes the mutex as free
+* \param mutex The mutex
+*/
+void MutexInit(TaskMutex_t *mutex)
+{
+	TASK_CRITICAL_SECTION (
+		mutex->owner = -1;
+		mutex->count = 0;
+		mutex->waitHead = -1;
+		mutex->nextHeld = 0;
+	);
+}
+
+
+
+/**
+* \brief Tries to lock the mutex for the current task without waiting. A task can lock a mutex it holds again, unlocking it as many times
+* \param mutex The mutex
+* \ret 1 if locked, 0 if held by another task
+*/
+uint8_t MutexTryLock(TaskMutex_t *mutex)
+{
+	const TaskIndiceType_t id = GetCurrentTaskID();
+	uint8_t locked = 1;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//If we're free, take us
+		if(mutex->owner < 0)
 		{
-			return 0;
+			TaskControl_t *task = _GetTaskControl(_GetTaskIndex(id));
+			
+			mutex->owner = id;
+			mutex->count = 1;
+			mutex->nextHeld = task->heldMutexes;
+			task->heldMutexes = mutex;
 		}
+		//Else if we already hold it, count again
+		else if(mutex->owner == id)
+		{
+			mutex->count++;
+		}
+		//Else someone else has it
+		else
+		{
+			locked = 0;
+		}
+	);
+	
+	return locked;
+}
+
+
+
+/**
+* \brief Locks the mutex for the current task, blocking in priority order until it is handed over. \n
+* While we wait, the owner runs at our priority if that is higher, so middle priority tasks can't hold us up
+* \param mutex The mutex
+*/
+void MutexLock(TaskMutex_t *mutex)
+{
+	const TaskIndiceType_t id = GetCurrentTaskID();
+	
+	//If we got it straight away, we're done
+	if(MutexTryLock(mutex))
+	{
+		return;
 	}
 	
+	TASK_CRITICAL_SECTION (
+	
+		//If it was let go in the meantime, take it, else wait for it
+		if(mutex->owner < 0)
+		{
+			TaskControl_t *task = _GetTaskControl(_GetTaskIndex(id));
+			
+			mutex->owner = id;
+			mutex->count = 1;
+			mutex->nextHeld = task->heldMutexes;
+			task->heldMutexes = mutex;
+		}
+		else
+		{
+			//Block in the wait list
+			_GetTaskControl(_GetTaskIndex(id))->blockedOn = mutex;
+			_TaskBlock(_GetTaskIndex(id), &mutex->waitHead);
+			
+			//Lend our priority to the owner, and on down the chain
+			_MutexPropagatePriority(_GetTaskIndex(mutex->owner));
+		}
+	);
 	
+	//Give up the processor until we're handed the mutex
+	while(mutex->owner != id)
+	{
+		TaskYieldNow();
+	}
+}
+
 
-	TASK_CRITICAL_SECTION ( m_semAccessor++; );
+
+/**
+* \brief Unlocks the mutex held by the current task. Once unlocked as many times as it was locked, it goes to the first waiter \n
+* and we go back to our own priority, keeping any we're lent through the other mutexes we hold
+* \param mutex The mutex
+* \ret 1 if unlocked, 0 if the current task does not hold it
+*/
+uint8_t MutexUnlock(TaskMutex_t *mutex)
+{
+	const TaskIndiceType_t id = GetCurrentTaskID();
+	uint8_t unlocked = 1;
 	
+	TASK_CRITICAL_SECTION (
 	
-	return 1;
+		//If we don't hold it, we can't unlock it
+		if(mutex->owner != id)
+		{
+			unlocked = 0;
+		}
+		//Else if this was the last of our locks...
+		else if(--mutex->count == 0)
+		{
+			TaskControl_t *task = _GetTaskControl(_GetTaskIndex(id));
+			TaskMutex_t **link = &task->heldMutexes;
+			
+			//Unlink from the mutexes we hold
+			while(*link != 0)
+			{
+				if(*link == mutex)
+				{
+					*link = mutex->nextHeld;
+					break;
+				}
+				
+				link = &(*link)->nextHeld;
+			}
+			
+			mutex->nextHeld = 0;
+			
+			//Hand it on and drop back to the priority we're still owed
+			_MutexHandOff(mutex);
+			_MutexPropagatePriority(_GetTaskIndex(id));
+		}
+	);
+	
+	return unlocked;
 }
 
 
 
+#if TASK_EVENT_GROUPS
+
 /**
-* \brief Closes the request for the semaphore accessor
-*
+* \brief Returns true if the bits satisfy the wait for the mask
+* \param bits The bits of the group
+* \param mask The bits waited on
+* \param options TASK_EVENT_WAIT_ALL to need every bit of the mask, else any
 */
-uint8_t CloseSemaphoreRequest()
+static inline bool _EventGroupSatisfied(TaskEventBits_t bits, TaskEventBits_t mask, uint8_t options)
 {
-	if(m_semAccessor <= 0)
+	return (options & TASK_EVENT_WAIT_ALL) ? ((bits & mask) == mask) : ((bits & mask) != 0);
+}
+
+
+
+/**
+* \brief Sets the bits of the group and wakes every waiter they now satisfy, clearing the bits they asked to. Interrupts must be off.
+* \param group The event group
+* \param bits The bits to set
+* \ret The bits of the group once done
+*/
+static TaskEventBits_t _EventGroupSet(TaskEventGroup_t *group, TaskEventBits_t bits)
+{
+	TaskEventBits_t clearBits = 0;
+	TaskIndiceType_t index = group->waitHead;
+	
+	group->bits |= bits;
+	
+	//Only the tasks waiting on us are checked
+	while(index >= 0)
 	{
-		TASK_CRITICAL_SECTION ( m_semAccessor = 0; );
-		return 0;
+		TaskControl_t *task = _GetTaskControl(index);
+		const TaskIndiceType_t next = task->waitNext;
+		
+		//If we're satisfied, hand over the bits that woke us and wake
+		if(_EventGroupSatisfied(group->bits, task->eventBits, task->eventOptions))
+		{
+			if(task->eventOptions & TASK_EVENT_CLEAR_ON_EXIT)
+			{
+				clearBits |= task->eventBits;
+			}
+			
+			task->eventBits = group->bits;
+			_TaskWake(index);
+		}
+		
+		index = next;
 	}
-	else
+	
+	//Everyone woken saw the bits before they're cleared
+	group->bits &= ~clearBits;
+	
+	return group->bits;
+}
+
+
+
+/**
+* \brief Initializes the event group with no bits set and no waiters
+* \param group The event group
+*/
+void EventGroupInit(TaskEventGroup_t *group)
+{
+	TASK_CRITICAL_SECTION (
+		group->bits = 0;
+		group->waitHead = -1;
+	);
+}
+
+
+
+/**
+* \brief Waits for any of the bits in the mask to be set, or all of them with TASK_EVENT_WAIT_ALL. \n
+* The task is blocked until then, and only checked again when bits are set in the group
+* \param group The event group
+* \param mask The bits to wait on
+* \param options TASK_EVENT_WAIT_ALL and TASK_EVENT_CLEAR_ON_EXIT, or 0
+* \param timeout The ticks to wait at most, 0 to not wait or TASK_WAIT_FOREVER to wait until satisfied
+* \ret The bits of the group when the wait was satisfied, before any were cleared, 0 if the timeout ran out
+*/
+TaskEventBits_t EventGroupWait(TaskEventGroup_t *group, TaskEventBits_t mask, uint8_t options, TaskTimeout_t timeout)
+{
+	const TaskIndiceType_t index = _GetCurrentTaskIndex();
+	TaskEventBits_t bits = 0;
+	bool blocked = false;
+	
+	TASK_CRITICAL_SECTION (
+	
+		//If we're already satisfied, take the bits
+		if(_EventGroupSatisfied(group->bits, mask, options))
+		{
+			bits = group->bits;
+			
+			if(options & TASK_EVENT_CLEAR_ON_EXIT)
+			{
+				group->bits &= ~mask;
+			}
+		}
+		//Else if we can wait, block until a set satisfies us
+		else if(timeout != 0 && index >= 0)
+		{
+			TaskControl_t *task = _GetTaskControl(index);
+			
+			task->eventBits = mask;
+			task->eventOptions = options;
+			_TaskBlockFor(index, &group->waitHead, TASK_WAIT_PRIORITY, timeout);
+			blocked = true;
+		}
+	);
+	
+	//The set that woke us left the bits in our task control
+	if(blocked && _TaskWaitWoken(index))
 	{
-		TASK_CRITICAL_SECTION ( m_semAccessor -= 1; );
-		return 1;
+		bits = _GetTaskControl(index)->eventBits;
 	}
+	
+	return bits;
+}
+
+
+
+/**
+* \brief Sets the bits of the event group from a task, waking every waiter they satisfy
+* \param group The event group
+* \param bits The bits to set
+* \ret The bits of the group once done
+*/
+TaskEventBits_t EventGroupSet(TaskEventGroup_t *group, TaskEventBits_t bits)
+{
+	TaskEventBits_t groupBits;
+	
+	TASK_CRITICAL_SECTION ( groupBits = _EventGroupSet(group, bits); );
+	
+	return groupBits;
 }
 
 
 
+/**
+* \brief Sets the bits of the event group from an interrupt, waking every waiter they satisfy. Interrupts must be off, as they are in an ISR
+* \param group The event group
+* \param bits The bits to set
+* \ret The bits of the group once done
+*/
+TaskEventBits_t EventGroupSetFromISR(TaskEventGroup_t *group, TaskEventBits_t bits)
+{
+	return _EventGroupSet(group, bits);
+}
+
+
+
+/**
+* \brief Clears the bits of the event group
+* \param group The event group
+* \param bits The bits to clear
+* \ret The bits of the group before they were cleared
+*/
+TaskEventBits_t EventGroupClear(TaskEventGroup_t *group, TaskEventBits_t bits)
+{
+	TaskEventBits_t groupBits;
+	
+	TASK_CRITICAL_SECTION (
+		groupBits = group->bits;
+		group->bits &= ~bits;
+	);
+	
+	return groupBits;
+}
+
+
+
+/**
+* \brief Returns the bits of the event group
+* \param group The event group
+*/
+TaskEventBits_t EventGroupGet(TaskEventGroup_t *group)
+{
+	TaskEventBits_t groupBits;
+	
+	TASK_CRITICAL_SECTION ( groupBits = group->bits; );
+	
+	return groupBits;
+}
+
+#endif
+
+
+
@@ -5,6 +5,8 @@
  */
 #include "PreemptiveTaskScheduler.h"
 
+#include <stddef.h>
+
 
 
 #if defined(__GNUC__) || defined(GCC)
@@ -18,9 +20,41 @@
 ///An array block of our task control structures
 static TaskControl_t m_TaskControl[MAX_TASKS+1] __attribute__ ((weakref));
 
+///The status of each control slot
+static volatile TaskStatus_t m_TaskStatus[MAX_TASKS+1] __attribute__ ((weakref));
+
+///The priority level of each control slot
+static TaskPriorityLevel_t m_TaskPriority[MAX_TASKS+1] __attribute__ ((weakref));
+
 ///The index for our Task control block structure
 static TaskIndiceType_t m_TaskBlockIndex __attribute__ ((weakref));
 
+///The slots of the tasks in the order the reorder schedule runs them
+static TaskIndiceType_t m_RunOrder[MAX_TASKS] __attribute__ ((weakref));
+
+///The position in the run order of the task last picked
+static TaskIndiceType_t m_RunPosition __attribute__ ((weakref));
+
+#if TASK_DEADLINES
+
+///The runnable task with the nearest absolute deadline
+static TaskIndiceType_t m_DeadlineHead __attribute__ ((weakref));
+
+///Bitmap of every task attached as a periodic task
+static TaskMask_t m_PeriodicMask __attribute__ ((weakref));
+
+#endif
+
+#if TASK_STRIDE_SCHEDULING
+
+///The pass of the task last picked under stride scheduling
+static uint16_t m_StridePass __attribute__ ((weakref));
+
+#endif
+
+///If the switch was asked for by a task instead of the scheduler tick
+static volatile bool m_VoluntarySwitch __attribute__ ((weakref));
+
 ///Count of the total items we've placed into the task control block
 static TaskIndiceType_t m_TaskBlockCount __attribute__ ((weakref));
 
@@ -36,6 +70,27 @@ static bool m_blnTasksRunning __attribute__ ((weakref));
 ///The type of task schedule to use
 static TaskSchedule_t m_TaskSchedule __attribute__ ((weakref));
 
+///Bitmap of every runnable task, one bit per control slot
+static TaskMask_t m_ReadyMask __attribute__ ((weakref));
+
+///Runnable task bitmaps split by priority band
+static TaskMask_t m_ReadyBands[TASK_PRIORITY_BANDS] __attribute__ ((weakref));
+
+///Bitmap of the priority bands that have at least one runnable task
+static uint8_t m_ReadyBandMask __attribute__ ((weakref));
+
+///Bitmap of every task set as READY or MAIN
+static TaskMask_t m_ReadyStatusMask __attribute__ ((weakref));
+
+///Bitmap of every task that has not been killed or released
+static TaskMask_t m_LiveMask __attribute__ ((weakref));
+
+///Bitmap of every task waiting to be killed by the scheduler
+static TaskMask_t m_KillMask __attribute__ ((weakref));
+
+///The amount of slices the scheduler interrupt was loaded for
+static uint16_t m_TickSlices __attribute__ ((weakref));
+
 
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
@@ -53,9 +108,9 @@ __attribute__ ((weak)) TaskPriorityLevel_t FindNextHighestPriorityLevel()
 	
 	for (TaskIndiceType_t t = m_TaskBlockIndex+1; t <= MAX_TASKS; t++)
 	{
-		if(m_TaskControl[t].priority > p)
+		if(m_TaskPriority[t] > p)
 		{
-			p=m_TaskControl[t].priority;
+			p=m_TaskPriority[t];
 		}
 	}
 	
@@ -65,197 +120,337 @@ __attribute__ ((weak)) TaskPriorityLevel_t FindNextHighestPriorityLevel()
 
 
 /**
-* \brief Returns the next task with the highest of the upcoming priority levels
+* \brief Returns the bitmap of tasks that can be switched to. The main task is left out when it is the empty task.
 *
 */
-__attribute__ ((weak)) TaskIndiceType_t FindNextHighestPriorityTask()
+static inline TaskMask_t _SwitchCandidates(void)
 {
-	TaskIndiceType_t rt=m_TaskBlockIndex;
-	TaskPriorityLevel_t p=-1;
+	//If our main task is set to the EMPTY function, leave it out of the rotation
+	if((TaskMemoryLocationType_t)m_TaskControl[MAX_TASKS].task_func == (TaskMemoryLocationType_t)_EmptyTask)
+	{
+		return m_ReadyMask & ~((TaskMask_t)1 << MAX_TASKS);
+	}
+	
+	return m_ReadyMask;
+}
 
-	for (TaskIndiceType_t t = 0; t <= MAX_TASKS; t++)
+
+
+/**
+* \brief Narrows the candidates of the top band to those at its highest priority, since every priority at or above the top band shares it
+* \param candidates Bitmap of the runnable tasks in the top band
+* \ret The candidates at the highest priority, found by visiting only the set bits
+*/
+static TaskMask_t _TopBandHighest(TaskMask_t candidates)
+{
+	TaskMask_t highest = 0;
+	TaskPriorityLevel_t p = TASK_PRIORITY_BANDS - 1;
+	
+	while(candidates != 0)
 	{
-		if(m_TaskControl[t].priority >= p && m_TaskControl[t].taskStatus != TASK_BLOCKED && m_TaskControl[t].taskStatus != TASK_NONE && m_TaskControl[t].taskStatus != TASK_KILL && t != m_TaskBlockIndex)
+		const TaskIndiceType_t t = _LowestSetBit(candidates);
+		
+		//Drop the bit we're visiting
+		candidates &= candidates - 1;
+		
+		//A higher priority starts the set over, an equal one joins it
+		if(m_TaskPriority[t] > p)
 		{
-			p=m_TaskControl[t].priority;
-			rt = t;
+			p = m_TaskPriority[t];
+			highest = 0;
 		}
-		else if(p < 0 && m_TaskControl[t].taskStatus == TASK_MAIN)
+		
+		if(m_TaskPriority[t] == p)
 		{
-			p=m_TaskControl[t].priority;
-			rt = t;
+			highest |= ((TaskMask_t)1 << t);
 		}
 	}
-	return rt;
+	
+	return highest;
 }
 
 
 
 /**
-* \brief Returns the next task with the highest of the upcoming priority levels but excludes previously gotten priorities until all possible are added
+* \brief Returns the next task with the highest of the upcoming priority levels
 *
 */
-__attribute__ ((weak)) TaskIndiceType_t FindNextPriorityTask()
+__attribute__ ((weak)) TaskIndiceType_t FindNextHighestPriorityTask()
 {
-	TaskIndiceType_t rt=m_TaskBlockIndex;
-	TaskPriorityLevel_t p=-1;
-	static TaskIndiceType_t taskChecker[MAX_TASKS+1];
+	const TaskMask_t allowed = _SwitchCandidates() & ~((TaskMask_t)1 << m_TaskBlockIndex);
+	uint8_t bands = m_ReadyBandMask;
 	
-	for (TaskIndiceType_t t = 0; t <= MAX_TASKS; t++)
+	//Walk down the occupied bands. Only our own bit and the empty task are excluded, so this runs at most three times
+	while(bands != 0)
 	{
-		if(m_TaskControl[t].priority >= p && m_TaskControl[t].taskStatus != TASK_BLOCKED && m_TaskControl[t].taskStatus != TASK_NONE && m_TaskControl[t].taskStatus != TASK_KILL && t != m_TaskBlockIndex)
+		const uint8_t band = _HighestSetBit8(bands);
+		TaskMask_t candidates = m_ReadyBands[band] & allowed;
+		
+		//If anyone else is in this band, take the next one after us so equal priorities take turns
+		if(candidates != 0)
 		{
-			if(taskChecker[rt] != rt)
+			//The top band holds every priority above it too, so only its highest take turns
+			if(band == TASK_PRIORITY_BANDS - 1)
 			{
-				p=m_TaskControl[t].priority;
-				rt = t;
+				candidates = _TopBandHighest(candidates);
 			}
 			
+			return _NextSetBitAfter(candidates, m_TaskBlockIndex);
 		}
 		
+		bands &= ~(1 << band);
 	}
 	
-	if(rt == m_TaskBlockIndex)
+	return m_TaskBlockIndex;
+}
+
+
+
+/**
+* \brief Picks the highest priority runnable task that has not been picked yet this round, starting a new round once everyone has run
+* \param pending Bitmap of the tasks not yet picked this round
+* \param statuses Bitmap of the tasks whose status allows them to be picked
+*/
+static TaskIndiceType_t _FindNextRoundPriorityTask(TaskMask_t *pending, TaskMask_t statuses)
+{
+	const TaskMask_t allowed = _SwitchCandidates() & statuses & ~((TaskMask_t)1 << m_TaskBlockIndex);
+	
+	//Try our current round, then a fresh round
+	for(uint8_t round = 0; round < 2; round++)
 	{
-		for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
+		//Walk the bands from the highest down
+		for(int8_t band = TASK_PRIORITY_BANDS - 1; band >= 0; band--)
 		{
-			taskChecker[i] = -1;
+			const TaskMask_t candidates = m_ReadyBands[band] & *pending & allowed;
+			
+			//If anyone in this band hasn't had a turn, take them off the round and use them
+			if(candidates != 0)
+			{
+				const TaskIndiceType_t rt = _NextSetBitAfter(candidates, m_TaskBlockIndex);
+				*pending &= ~((TaskMask_t)1 << rt);
+				return rt;
+			}
 		}
+		
+		//Everyone has had a turn, start a new round
+		*pending = (TaskMask_t)~0;
 	}
 	
+	return m_TaskBlockIndex;
+}
+
+
+
+#if TASK_DEADLINES
+
+/**
+* \brief Returns the runnable task with the nearest absolute deadline, or the next runnable task after us when no task with a deadline can run
+*
+*/
+__attribute__ ((weak)) TaskIndiceType_t FindNextDeadlineTask()
+{
+	TaskIndiceType_t rt;
 	
+	//The deadline list only holds runnable tasks, so the front of it goes
+	if(m_DeadlineHead >= 0)
+	{
+		return m_DeadlineHead;
+	}
 	
-	taskChecker[rt] = rt;
+	//Else everyone else takes turns
+	rt = _NextSetBitAfter(_SwitchCandidates(), m_TaskBlockIndex);
 	
-	return rt;
+	return (rt >= 0) ? rt : m_TaskBlockIndex;
 }
 
 
 
 /**
-* \brief Returns the next ready only task with the highest of the upcoming priority levels but excludes previously gotten priorities until all possible are added
+* \brief Returns the runnable periodic task in the highest priority band, taking turns within the band, or the next runnable task after us when no periodic task can run
 *
 */
-__attribute__ ((weak)) TaskIndiceType_t FindNextReadyPriorityTask()
+__attribute__ ((weak)) TaskIndiceType_t FindNextRateMonotonicTask()
 {
-	TaskIndiceType_t rt=m_TaskBlockIndex;
-	TaskPriorityLevel_t p=-1;
-	static TaskIndiceType_t taskChecker[MAX_TASKS+1];
+	const TaskMask_t periodic = _SwitchCandidates() & m_PeriodicMask;
+	uint8_t bands = m_ReadyBandMask;
+	TaskIndiceType_t rt;
 	
-	for (TaskIndiceType_t t = 0; t <= MAX_TASKS; t++)
+	//Walk down the occupied bands until one has a periodic task in it
+	while(periodic != 0 && bands != 0)
 	{
-		if(m_TaskControl[t].priority >= p  && (m_TaskControl[t].taskStatus == TASK_MAIN || m_TaskControl[t].taskStatus == TASK_READY) && t != m_TaskBlockIndex)
+		const uint8_t band = _HighestSetBit8(bands);
+		const TaskMask_t candidates = m_ReadyBands[band] & periodic;
+		
+		if(candidates != 0)
 		{
-			if(taskChecker[rt] != rt)
-			{
-				p=m_TaskControl[t].priority;
-				rt = t;
-			}
-			
+			return _NextSetBitAfter(candidates, m_TaskBlockIndex);
 		}
 		
+		bands &= ~(1 << band);
 	}
 	
-	if(rt == m_TaskBlockIndex)
+	//Else everyone else takes turns
+	rt = _NextSetBitAfter(_SwitchCandidates(), m_TaskBlockIndex);
+	
+	return (rt >= 0) ? rt : m_TaskBlockIndex;
+}
+
+#endif
+
+
+
+#if TASK_STRIDE_SCHEDULING
+
+/**
+* \brief Returns the runnable task with the lowest pass and moves its pass on by its stride. Equal passes take turns starting after us
+*
+*/
+__attribute__ ((weak)) TaskIndiceType_t FindNextStrideTask()
+{
+	TaskMask_t candidates = _SwitchCandidates();
+	TaskIndiceType_t rt = -1;
+	TaskIndiceType_t t = _NextSetBitAfter(candidates, m_TaskBlockIndex);
+	
+	//Walk every candidate from after us, keeping the lowest pass. Passes wrap, so compare by difference
+	while(candidates != 0)
 	{
-		for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
+		if(rt < 0 || (int16_t)(m_TaskControl[t].pass - m_TaskControl[rt].pass) < 0)
 		{
-			taskChecker[i] = -1;
+			rt = t;
 		}
+		
+		candidates &= ~((TaskMask_t)1 << t);
+		t = _NextSetBitAfter(candidates, t);
 	}
 	
+	//If nobody can run, stay put
+	if(rt < 0)
+	{
+		return m_TaskBlockIndex;
+	}
 	
-	
-	taskChecker[rt] = rt;
+	//Everyone joining starts from here, and we move on by our stride
+	m_StridePass = m_TaskControl[rt].pass;
+	m_TaskControl[rt].pass += m_TaskControl[rt].stride;
 	
 	return rt;
 }
 
+#endif
+
 
 
 /**
-* \brief Deep copy from src to dest
+* \brief Returns the next task with the highest of the upcoming priority levels but excludes previously gotten priorities until all possible are added
 *
 */
-__attribute__ ((weak)) void _TaskCpy(TaskControl_t *dest, TaskControl_t *src)
+__attribute__ ((weak)) TaskIndiceType_t FindNextPriorityTask()
 {
-	dest->defaultTimeout = src->defaultTimeout;
-	dest->priority = src->priority;
-	dest->task_func = src->task_func;
-	dest->taskData = src->taskData;
-	dest->taskExecutionContext = src->taskExecutionContext;
-	
-	dest->taskExecutionContext.sreg = src->taskExecutionContext.sreg;
-	dest->taskExecutionContext.sp.ptr = src->taskExecutionContext.sp.ptr;
-	dest->taskExecutionContext.pc.ptr = src->taskExecutionContext.pc.ptr;
+	static TaskMask_t pending = (TaskMask_t)~0;
 	
-	for(uint8_t i = 0; i < TASK_REGISTERS; i++)
-	{
-		dest->taskExecutionContext.registerFile[i] = src->taskExecutionContext.registerFile[i];
-	}
-	
-	
-	dest->taskID = src->taskID;
-	dest->taskStatus = src->taskStatus;
-	dest->timeout = src->timeout;
-	dest->_taskStack = src->_taskStack;
+	return _FindNextRoundPriorityTask(&pending, (TaskMask_t)~0);
 }
 
 
 
 /**
-* \brief Swaps tasks a and b
+* \brief Returns the next ready only task with the highest of the upcoming priority levels but excludes previously gotten priorities until all possible are added
 *
 */
-__attribute__ ((weak)) void _MemSwapTasks(TaskControl_t *taskA, TaskControl_t *taskB)
+__attribute__ ((weak)) TaskIndiceType_t FindNextReadyPriorityTask()
 {
-	//Intermediary value. Too many "complex" data types to easily use the ^ option ):
-	TaskControl_t tmpTask;
+	static TaskMask_t pending = (TaskMask_t)~0;
 	
-	_TaskCpy(&tmpTask, taskA);
-	_TaskCpy(taskA, taskB);
-	_TaskCpy(taskB, &tmpTask);
+	//Only READY and MAIN tasks, not SCHEDULED or SLEEP ones
+	return _FindNextRoundPriorityTask(&pending, m_ReadyStatusMask);
+}
+
+
+
+/**
+* \brief Returns the next runnable task after the passed index, wrapping around. The main task is skipped when it is the empty task.
+* \param after The index to search after
+* \ret The next index, -1 if nothing can run
+*/
+__attribute__ ((weak)) TaskIndiceType_t FindNextReadyTask(TaskIndiceType_t after)
+{
+	return _NextSetBitAfter(_SwitchCandidates(), after);
 }
 
 
 
 /**
-* \brief Reorders the task control collection based on priority settings
+* \brief Reorders the run order based on priority settings. Only the slot indices are moved, the task controls stay where they are
 *
 */
 __attribute__ ((weak)) void _PriorityReorderTasks(void)
 {
-	//Loop through all tasks and...
+	//Loop through the run order and...
 	for(TaskIndiceType_t i = 1; i < MAX_TASKS; i++)
 	{
-		//If our current priority level is set higher than our previous priority level...
-		if(m_TaskControl[i].priority > m_TaskControl[i-1].priority)
+		const TaskIndiceType_t slot = m_RunOrder[i];
+		TaskIndiceType_t j = i;
+		
+		//While the one in front of us has a lower priority level, move it back
+		while(j > 0 && m_TaskPriority[slot] > m_TaskPriority[m_RunOrder[j-1]])
 		{
-			//Loop through all tasks and...
-			for(TaskIndiceType_t j = i; j > 0; j--)
-			{				
-				//If our current priority level is set higher than our previous priority level...
-				if(m_TaskControl[j].priority > m_TaskControl[j-1].priority)
-				{
-					//Move to the front
-					_MemSwapTasks(&m_TaskControl[j], &m_TaskControl[j-1]);
-				}
-				//else...
-				else
-				{
-					//break outta here
-					break;
-				}
-			}
+			m_RunOrder[j] = m_RunOrder[j-1];
+			j--;
 		}
+		
+		//Drop in where we stopped
+		m_RunOrder[j] = slot;
 	}
 }
 
 
 
+/**
+* \brief Returns the next runnable task in the run order, the main task after the last of it, sorting the order again each time it comes back around
+* \ret The slot of the task, -1 if nobody can run
+*/
+__attribute__ ((weak)) TaskIndiceType_t FindNextOrderedTask()
+{
+	const TaskMask_t candidates = _SwitchCandidates();
+	
+	//Step through each position at most once
+	for(TaskIndiceType_t step = 0; step <= MAX_TASKS; step++)
+	{
+		//If we're past the main task, sort and start over, else move up one
+		if(m_RunPosition >= MAX_TASKS)
+		{
+			_PriorityReorderTasks();
+			m_RunPosition = 0;
+		}
+		else
+		{
+			m_RunPosition++;
+		}
+		
+		const TaskIndiceType_t slot = (m_RunPosition < MAX_TASKS) ? m_RunOrder[m_RunPosition] : MAX_TASKS;
+		
+		//If the task here can run, use it
+		if(candidates & ((TaskMask_t)1 << slot))
+		{
+			return slot;
+		}
+	}
+	
+	return -1;
+}
 
 
 
+/**
+* \brief Steps the priority of the chosen task down, restoring it from the cached priority once it runs out
+* \param index The task control index
+*/
+static inline void _DecayTaskPriority(TaskIndiceType_t index)
+{
+	_WriteTaskPriority(index, (m_TaskPriority[index] > 0) ? m_TaskPriority[index] - 1 : m_TaskControl[index].cachedPriority);
+}
+
+
 
 /**
 * \brief Handles task switching
@@ -263,154 +458,141 @@ __attribute__ ((weak)) void _PriorityReorderTasks(void)
 */
 __attribute__ ((weak)) void _TaskSwitch(void)
 {
+	//A switch asked for by a task happens mid slice, so no tick has passed and the timer is left running
+	const bool voluntary = m_VoluntarySwitch;
+	m_VoluntarySwitch = false;
 	
-	//Get our current task block index
-	m_TaskBlockIndex = _GetTaskIndex(m_CurrentTask->taskID);
-	
-	//If our task index is out of range somehow...
+	//Our block index is kept as the current task's slot, so there's nothing to look up. If it is out of range somehow...
 	if(m_TaskBlockIndex < 0 || m_TaskBlockIndex > MAX_TASKS)
 	{
-		//Return
+		//Keep ticking over the same amount of slices and return
+		#if TASK_TICKLESS_IDLE
+			if(!voluntary)
+			{
+				_SCHEDULER_LOAD_ISR_SLICES(m_TickSlices);
+			}
+		#endif
+		
 		return;
 	}
 	
-	//If our task is scheduled to be killed...
-	if(m_TaskControl[m_TaskBlockIndex].taskStatus == TASK_KILL)
+	#if TASK_STACK_CHECK
+	
+		//If the task we're leaving ran past the bottom of its stack, its paint is gone or its stack pointer is under it
+		if(m_TaskControl[m_TaskBlockIndex].stackBottom != 0 && 
+		(m_TaskControl[m_TaskBlockIndex].stackBottom[0] != TASK_STACK_PAINT || (uint8_t *)m_TaskControl[m_TaskBlockIndex].taskExecutionContext.sp.ptr < m_TaskControl[m_TaskBlockIndex].stackBottom))
+		{
+			TaskStackOverflow(m_TaskControl[m_TaskBlockIndex].taskID);
+		}
+	
+	#endif
+	
+	//Kill every task that is scheduled to be killed. The main task is never killed
+	while((m_KillMask & ~((TaskMask_t)1 << MAX_TASKS)) != 0)
 	{
 		//Kill it
-		_KillTaskImmediate(m_TaskBlockIndex);
+		_KillTaskImmediate(_LowestSetBit(m_KillMask & ~((TaskMask_t)1 << MAX_TASKS)));
 	}
 	
-	//Loop through all tasks and...
-	for(TaskIndiceType_t i = 0; i <= MAX_TASKS; i++)
+	//Any stretched interval is over now, so move our tick count forward by every slice it covered and wake anyone that is due
+	if(!voluntary)
 	{
-		//If the task is in a state that allows us...
-		if(m_TaskControl[i].taskStatus != TASK_BLOCKED && m_TaskControl[i].taskStatus != TASK_NONE && m_TaskControl[i].taskStatus != TASK_SLEEP)
-		{
-			//If our task counts are greater than 0...
-			if(m_TaskControl[i].timeout > 0)
-			{
-				
-				//If Decrementing our count is now less than or equal to 0...
-				m_TaskControl[i].timeout -= 1;
-				
-				if(m_TaskControl[i].timeout <= 0)
-				{
-					//If our task is set to YIELD...
-					if(m_TaskControl[i].taskStatus == TASK_YIELD)
-					{
-						//Set task back to ready
-						m_TaskControl[i].taskStatus = TASK_READY;
-					}
-					
-					//Reset to our default timeout
-					m_TaskControl[i].timeout = m_TaskControl[i].defaultTimeout;
-				}
-			}
-			
-		}
+		const uint16_t elapsedSlices = m_TickSlices;
+		m_TickSlices = 1;
+		_TimerService(elapsedSlices);
 	}
 	
-	if(m_TaskSchedule != TASK_SCHEDULE_ROUND_ROBIN)
+	//Check our schedule type. Each schedule leaves our block index one before the task it wants
+	switch (m_TaskSchedule)
 	{
-		//Check our schedule type
-		switch (m_TaskSchedule)
-		{
-			case TASK_SCHEDULE_PRIORITY:
-				m_TaskBlockIndex = (FindNextPriorityTask()-1);
-				if(--m_TaskControl[m_TaskBlockIndex].priority < 0)
-				{
-					m_TaskControl[m_TaskBlockIndex].priority = m_TaskControl[m_TaskBlockIndex].cachedPriority;
-				}
-			break;
-			
-			
-			case TASK_SCHEDULE_PRIORITY_AND_READY:
-				m_TaskBlockIndex = (FindNextReadyPriorityTask()-1);
-				if(--m_TaskControl[m_TaskBlockIndex].priority < 0)
-				{
-					m_TaskControl[m_TaskBlockIndex].priority = m_TaskControl[m_TaskBlockIndex].cachedPriority;
-				}
-			break;
-			
-			
-			//Requires a specialized task manager for ordering and changing
-			case TASK_SCHEDULE_PRIORITY_STRICT:
-				
-				if(m_TaskBlockIndex == MAX_TASKS)
-				{
-					m_TaskBlockIndex = (FindNextHighestPriorityTask()-1);
-				}
-				else
-				{
-					m_TaskBlockIndex = MAX_TASKS - 1;
-				}
-				
-			break;
-			
-			//Prioritizes function status's marked as MAIN to operate every other interrupt
-			case TASK_SCHEDULE_PRIORITY_MAIN:
-				
-				if(m_TaskBlockIndex == MAX_TASKS)
-				{
-					m_TaskBlockIndex = (FindNextPriorityTask()-1);
-					if(--m_TaskControl[m_TaskBlockIndex].priority < 0)
-					{
-						m_TaskControl[m_TaskBlockIndex].priority = m_TaskControl[m_TaskBlockIndex].cachedPriority;
-					}
-				}
-				else
-				{
-					m_TaskBlockIndex = MAX_TASKS - 1;
-				}
-				
-			break;
-			
+		case TASK_SCHEDULE_PRIORITY:
+			m_TaskBlockIndex = (FindNextPriorityTask()-1);
+			_DecayTaskPriority(m_TaskBlockIndex+1);
+		break;
+		
+		
+		case TASK_SCHEDULE_PRIORITY_AND_READY:
+			m_TaskBlockIndex = (FindNextReadyPriorityTask()-1);
+			_DecayTaskPriority(m_TaskBlockIndex+1);
+		break;
+		
+		
+		//Requires a specialized task manager for ordering and changing
+		case TASK_SCHEDULE_PRIORITY_STRICT:
 			
-			case TASK_SCHEDULE_PRIORITY_REORDER:
-				if(m_TaskBlockIndex == 0)
-				{
-					_PriorityReorderTasks();	
-				}
-			break;
+			if(m_TaskBlockIndex == MAX_TASKS)
+			{
+				m_TaskBlockIndex = (FindNextHighestPriorityTask()-1);
+			}
+			else
+			{
+				m_TaskBlockIndex = MAX_TASKS - 1;
+			}
 			
-			default:
-			break;
-		};
-	}
-	
-	//Safety counter
-	volatile int8_t safety = 100;
-	
-	//do this...
-	do
-	{
-		//Increment our block index
-		m_TaskBlockIndex++;
+		break;
 		
-		//If our main task is set to the EMPTY function...
-		if((TaskMemoryLocationType_t)m_TaskControl[MAX_TASKS].task_func == (TaskMemoryLocationType_t)_EmptyTask)
-		{
-			//Range check our block index
-			if(m_TaskBlockIndex >= MAX_TASKS)
+		//Prioritizes function status's marked as MAIN to operate every other interrupt
+		case TASK_SCHEDULE_PRIORITY_MAIN:
+			
+			if(m_TaskBlockIndex == MAX_TASKS)
+			{
+				m_TaskBlockIndex = (FindNextPriorityTask()-1);
+				_DecayTaskPriority(m_TaskBlockIndex+1);
+			}
+			else
 			{
-				m_TaskBlockIndex = 0;
+				m_TaskBlockIndex = MAX_TASKS - 1;
 			}
-		}
-		//else...
-		else
+			
+		break;
+		
+		
+		#if TASK_DEADLINES
+		
+		case TASK_SCHEDULE_RATE_MONOTONIC:
+			m_TaskBlockIndex = (FindNextRateMonotonicTask()-1);
+		break;
+		
+		
+		case TASK_SCHEDULE_EDF:
+			m_TaskBlockIndex = (FindNextDeadlineTask()-1);
+		break;
+		
+		#endif
+		
+		#if TASK_STRIDE_SCHEDULING
+		
+		case TASK_SCHEDULE_STRIDE:
+			m_TaskBlockIndex = (FindNextStrideTask()-1);
+		break;
+		
+		#endif
+		
+		
+		case TASK_SCHEDULE_PRIORITY_REORDER:
 		{
-			//Range check our block index
-			if(m_TaskBlockIndex > MAX_TASKS)
+			const TaskIndiceType_t ordered = FindNextOrderedTask();
+			
+			//If anyone in the run order can go, go to them
+			if(ordered >= 0)
 			{
-				m_TaskBlockIndex = 0;
-				
+				m_TaskBlockIndex = ordered - 1;
 			}
 		}
+		break;
 		
-		
-		//If our safety is bad, meaning we have reached some form of catastrophic failure ): or all tasks have been killed ...
-		if(--safety <= 0)
+		default:
+		break;
+	};
+	
+	//Take the first runnable task from the one our schedule wants onward
+	m_TaskBlockIndex = FindNextReadyTask(m_TaskBlockIndex);
+	
+	//If nothing can run...
+	if(m_TaskBlockIndex < 0)
+	{
+		//If every task has been killed...
+		if((m_LiveMask & ~((TaskMask_t)1 << MAX_TASKS)) == 0)
 		{
 			//Set our tasks running to false
 			m_blnTasksRunning = false;
@@ -427,26 +609,23 @@ __attribute__ ((weak)) void _TaskSwitch(void)
 			
 			//Make sure our schedulers ticking is stopped
 			_SCHEDULER_STOP_TICK();
-			
-			//Break and return to wherever it is we go when tasks die.
-			break;
 		}
 		
+		//Return to wherever it is we go when tasks die, or idle there until someone wakes
+		m_TaskBlockIndex = MAX_TASKS;
 	}
-	//While our tasks are either blocked, set to none, or are set to be killed
-	while(m_TaskControl[m_TaskBlockIndex].taskStatus == TASK_BLOCKED || m_TaskControl[m_TaskBlockIndex].taskStatus == TASK_NONE || m_TaskControl[m_TaskBlockIndex].taskStatus == TASK_KILL);
 	
 	
 	
 	
 	//If our new process is not set to a blocked status...
-	if(m_TaskControl[m_TaskBlockIndex].taskStatus != TASK_BLOCKED && m_TaskControl[m_TaskBlockIndex].taskStatus != TASK_NONE && m_TaskControl[m_TaskBlockIndex].taskStatus != TASK_KILL)
+	if(m_TaskStatus[m_TaskBlockIndex] != TASK_BLOCKED && m_TaskStatus[m_TaskBlockIndex] != TASK_NONE && m_TaskStatus[m_TaskBlockIndex] != TASK_KILL)
 	{
 		//if our task is set to be scheduled...
-		if(m_TaskControl[m_TaskBlockIndex].taskStatus == TASK_SCHEDULED)
+		if(m_TaskStatus[m_TaskBlockIndex] == TASK_SCHEDULED)
 		{
 			//Set as ready
-			m_TaskControl[m_TaskBlockIndex].taskStatus = TASK_READY;
+			_WriteTaskStatus(m_TaskBlockIndex, TASK_READY);
 			
 			//Go to our reserved task
 			m_TaskBlockIndex = MAX_TASKS;
@@ -466,12 +645,38 @@ __attribute__ ((weak)) void _TaskSwitch(void)
 		m_CurrentTask = &m_TaskControl[MAX_TASKS];
 	}
 	
+	#if TASK_TICKLESS_IDLE
+	
+		//The timer keeps running through a voluntary switch, our next tick picks up from there
+		if(voluntary)
+		{
+			return;
+		}
 	
+		//If nobody else could run, nothing needs the next slice boundary, so sleep until the next wake. Else, tick as normal
+		if((_SwitchCandidates() & ~((TaskMask_t)1 << m_TaskBlockIndex)) == 0)
+		{
+			m_TickSlices = _TimerTicksUntilNext(TASK_TICKLESS_MAX_SLICES);
+		}
+		else
+		{
+			m_TickSlices = 1;
+		}
+		
+		//Load the interrupt here, before the next context is restored, so no task registers are used for it
+		_SCHEDULER_LOAD_ISR_SLICES(m_TickSlices);
 	
+	#endif
 	
 }
 
 
+///Restores the context of the current task, only the registers a call has to keep if it was switched out by a yield. The flag is tested in the restore asm
+#define _TASK_RESTORE_CURRENT_CONTEXT()	\
+ASM_RESTORE_GLOBAL_PTR_FLAGGED_CONTEXT(m_CurrentTask, offsetof(TaskControl_t, contextPartial))
+
+
+
 #if defined(__GNUC__) || defined(GCC)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wreturn-type"
@@ -491,17 +696,20 @@ SCHEDULER_INTERRUPT_KEYWORD(SCHEDULER_INT_VECTOR, ISR_NAKED)
 	//Make sure other interrupts are disabled
 	SCHEDULER_ASM_INTERRUPTS_OFF();
 	
-	//Save our tasks context
+	//Save our tasks context, all of it since we could have stopped anywhere
 	ASM_SAVE_GLOBAL_PTR_CONTEXT(m_CurrentTask);
+	ASM_STORE_GLOBAL_PTR_BYTE(m_CurrentTask, offsetof(TaskControl_t, contextPartial), false);
 	
 	//Handle task switching
 	_TaskSwitch();
 	
 	//Restore our next context
-	ASM_RESTORE_GLOBAL_PTR_CONTEXT(m_CurrentTask);
+	_TASK_RESTORE_CURRENT_CONTEXT();
 	
-	//Make sure isr is reset before exiting...
-	_SCHEDULER_LOAD_ISR_REG();
+	//Make sure isr is reset before exiting. In tickless idle, the switch already loaded it
+	#if !TASK_TICKLESS_IDLE
+		_SCHEDULER_LOAD_ISR_REG();
+	#endif
 
 	//Make sure interrupts are re-enabled
 	SCHEDULER_ASM_INTERRUPTS_ON();
@@ -515,4 +723,34 @@ SCHEDULER_INTERRUPT_KEYWORD(SCHEDULER_INT_VECTOR, ISR_NAKED)
 #if defined(__GNUC__) || defined(GCC)
 #pragma GCC diagnostic pop
 #pragma GCC diagnostic pop
-#endif
\ No newline at end of file
+#endif
+
+
+
+/**
+* \brief Switches to the next task straight away instead of waiting for the scheduler tick. Saves our context like the scheduler interrupt, \n
+* runs the switch, and restores the next task's. The timer is left running, so the next task gets the rest of the slice. Only call from a task with interrupts on
+*
+*/
+__attribute__ ((naked, noinline)) void TaskYieldNow(void)
+{
+	//Make sure interrupts are disabled
+	SCHEDULER_ASM_INTERRUPTS_OFF();
+	
+	//Save our tasks context. We were called, so only the registers a call has to keep need saving, and our return address is on the stack
+	ASM_SAVE_GLOBAL_PTR_PARTIAL_CONTEXT(m_CurrentTask);
+	
+	//Mark it as partial and the switch as asked for. Naked, so no C may run until the switch, the stores are done in asm
+	ASM_STORE_GLOBAL_PTR_BYTE(m_CurrentTask, offsetof(TaskControl_t, contextPartial), true);
+	ASM_STORE_GLOBAL_BYTE(m_VoluntarySwitch, true);
+	
+	//Handle task switching
+	_TaskSwitch();
+	
+	//Restore our next context
+	_TASK_RESTORE_CURRENT_CONTEXT();
+	
+	//Return the same way the interrupt does, with interrupts re-enabled
+	SCHEDULER_ASM_INTERRUPTS_ON();
+	__SCHEDULER_ISR_ASM_RETURN();
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+/**
+ * \file PreemptiveTaskSchedulerTable.h
+ * \author: Tim Robbins
+ * \brief Task tables declared at compile time for preemptive task scheduling and concurrent functionality. \n
+ *
+ * A task table lists every task with its function, stack size, priority, period and worst case run time, as an X macro: \n
+ * \code
+ * #define MY_TASKS(X)				\
+ *	X(Blink, 96, 1, 0, 0)			\
+ *	X(ReadSensor, 128, 0, 50, 5)
+ *
+ * TASK_TABLE_DEFINE(MyTasks, MY_TASKS)
+ *
+ * AttachTaskTable(MyTasks, TASK_TABLE_COUNT(MyTasks));
+ * StartTasks(Idle, 0);
+ * \endcode
+ * The table is kept in flash, and checked at compile time to fit in MAX_TASKS and in the stack arena, \n
+ * or within TASK_STACK_SIZE for each task without an arena. Entry i is attached at slot i, so nothing is searched for at startup. \n
+ * Tasks with a period and worst case run time are periodic, and are given their priority by their period.
+ */
+#ifndef __PREEMPTIVETASKSCHEDULERTABLE_H__
+#define __PREEMPTIVETASKSCHEDULERTABLE_H__	1
+
+
+
+#ifdef	__cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+#include "PreemptiveTaskScheduler.h"
+
+#ifdef __AVR
+#include <avr/pgmspace.h>
+#endif
+
+
+
+#ifdef	__cplusplus
+	#define _TASK_TABLE_STATIC_ASSERT	static_assert
+#else
+	#define _TASK_TABLE_STATIC_ASSERT	_Static_assert
+#endif
+
+#ifdef __AVR
+	#define _TASK_TABLE_FLASH	PROGMEM
+#else
+	#define _TASK_TABLE_FLASH
+#endif
+
+
+
+///Expands one task of a table list to its entry
+#define _TASK_TABLE_ENTRY(func, stackSize, priority, period, wcet)	{ (void *)(func), (stackSize), (priority), (period), (wcet) },
+
+///Expands one task of a table list to a count of one
+#define _TASK_TABLE_ONE(func, stackSize, priority, period, wcet)	+ 1
+
+#if TASK_STACK_ARENA_SIZE > 0
+
+	///Expands one task of a table list to the bytes its stack takes from the arena
+	#define _TASK_TABLE_STACK(func, stackSize, priority, period, wcet)	+ (uint32_t)(stackSize)
+
+	///If the stacks of a table, totalled by _TASK_TABLE_STACK, fit in the arena
+	#define _TASK_TABLE_STACKS_FIT(total)	((total) <= TASK_STACK_ARENA_SIZE)
+
+#else
+
+	///Expands one task of a table list to 1 if its stack is bigger than the fixed stacks
+	#define _TASK_TABLE_STACK(func, stackSize, priority, period, wcet)	+ ((stackSize) > TASK_STACK_SIZE)
+
+	///If no stack of a table, counted by _TASK_TABLE_STACK, is bigger than the fixed stacks
+	#define _TASK_TABLE_STACKS_FIT(total)	((total) == 0)
+
+#endif
+
+#if TASK_DEADLINES
+
+	///Expands one task of a table list to a count of nothing, periodic tasks can be attached
+	#define _TASK_TABLE_PERIODIC(func, stackSize, priority, period, wcet)	+ 0
+
+#else
+
+	///Expands one task of a table list to 1 if it is periodic, which needs TASK_DEADLINES
+	#define _TASK_TABLE_PERIODIC(func, stackSize, priority, period, wcet)	+ ((period) > 0 && (wcet) > 0)
+
+#endif
+
+
+
+///Declares the task table Name in flash from the X macro list, each X(func, stackSize, priority, period, wcet), and checks it fits
+#define TASK_TABLE_DEFINE(Name, List)																							\
+																																\
+_TASK_TABLE_STATIC_ASSERT((0 List(_TASK_TABLE_ONE)) <= MAX_TASKS, #Name " has more tasks than MAX_TASKS");					\
+_TASK_TABLE_STATIC_ASSERT(_TASK_TABLE_STACKS_FIT(0 List(_TASK_TABLE_STACK)), #Name " stacks don't fit");						\
+_TASK_TABLE_STATIC_ASSERT((0 List(_TASK_TABLE_PERIODIC)) == 0, #Name " has periodic tasks without TASK_DEADLINES");			\
+																																\
+static const TaskTableEntry_t Name[] _TASK_TABLE_FLASH = { List(_TASK_TABLE_ENTRY) };
+
+
+
+///The count of tasks in a table declared with TASK_TABLE_DEFINE
+#define TASK_TABLE_COUNT(Name)	((TaskIndiceType_t)(sizeof(Name) / sizeof((Name)[0])))
+
+
+
+#ifdef	__cplusplus
+}
+#endif /* __cplusplus */
+
+
+
+#endif /* __PREEMPTIVETASKSCHEDULERTABLE_H__ */
@@ -0,0 +1,629 @@
+/**
+ * \file PreemptiveTaskSchedulerTimers.c
+ * \author: Tim Robbins
+ * \brief Source file for the timer wheel used by timeouts in preemptive task scheduling and concurrent functionality. \n
+ *
+ * Timers are kept in a hierarchical hashed wheel. Each level has 2^TASK_TIMER_WHEEL_BITS slots and every level up covers \n
+ * that many times the ticks of the one below it. Inserting and cancelling is O(1), and each tick only touches the timers \n
+ * that are due plus the ones cascading down a level, so the tick cost does not grow with the amount of pending timers. \n
+ * Deadlines past the span of the wheel are parked in the top level and placed again each time it turns. \n
+ * With TASK_TIMER_WHEEL_BITS set to 0, a single queue ordered by deadline is used instead. \n
+ * Software timers are kept in the same wheel. When one expires it is queued for the timer daemon task, \n
+ * which runs the callbacks of every timer on its one stack with interrupts on.
+ */
+#include "PreemptiveTaskScheduler.h"
+
+
+
+///The amount of scheduler ticks since the scheduler was first started
+static TaskTick_t m_TimerTicks;
+
+///Given when a software timer expires while the daemon has none waiting
+static TaskSemaphore_t m_SoftTimerReady = TASK_SEMAPHORE_INIT(0, 1, TASK_WAIT_PRIORITY);
+
+///The first and last software timers waiting on the daemon to run their callbacks
+static TaskSoftTimer_t *m_SoftTimerPendingHead;
+static TaskSoftTimer_t *m_SoftTimerPendingTail;
+
+#if TASK_TIMER_WHEEL_BITS > 0
+
+///The amount of slots in each wheel level
+#define TIMER_WHEEL_SLOTS		(1 << TASK_TIMER_WHEEL_BITS)
+
+///Mask for a slot index in a wheel level
+#define TIMER_WHEEL_MASK		(TIMER_WHEEL_SLOTS - 1)
+
+///The slots for each level of the wheel
+static TaskTimerNode_t *m_TimerWheel[TASK_TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+///Bitmap of the occupied slots in each level of the wheel
+static uint16_t m_TimerWheelOccupied[TASK_TIMER_WHEEL_LEVELS];
+
+#else
+
+///The first timer in the queue, ordered by deadline
+static TaskTimerNode_t *m_TimerQueueHead;
+
+#endif
+
+
+
+/**
+* \brief Links the timer in front of the list at the passed link. Interrupts must be off.
+* \param link The list head to link into
+* \param node The timer to link
+*/
+static inline void _TimerLink(TaskTimerNode_t **link, TaskTimerNode_t *node)
+{
+	node->next = *link;
+	node->link = link;
+
+	if(*link != 0)
+	{
+		(*link)->link = &node->next;
+	}
+
+	*link = node;
+}
+
+
+
+#if TASK_TIMER_WHEEL_BITS > 0
+
+/**
+* \brief Places the timer in the slot of the wheel its deadline falls in. Interrupts must be off.
+* \param node The timer to place
+* \param earliest The soonest tick the timer's slot can come up, for deadlines that have already passed
+*/
+static void _TimerPlace(TaskTimerNode_t *node, TaskTick_t earliest)
+{
+	TaskTick_t slotTick = node->deadline;
+	uint32_t distance;
+	uint8_t level = 0;
+	uint8_t slot;
+
+	//If our deadline has already passed, use the soonest slot we can
+	if((int32_t)(slotTick - earliest) < 0)
+	{
+		slotTick = earliest;
+	}
+
+	distance = slotTick - m_TimerTicks;
+
+	//Go up a level for every span we're further out than
+	while(level < TASK_TIMER_WHEEL_LEVELS - 1 && distance >= ((uint32_t)1 << (TASK_TIMER_WHEEL_BITS * (level + 1))))
+	{
+		level++;
+	}
+
+	#if (TASK_TIMER_WHEEL_BITS * TASK_TIMER_WHEEL_LEVELS) < 32
+
+		//If we're further out than the whole wheel, park in the slot that comes up last and get placed again when it does
+		if(distance >= ((uint32_t)1 << (TASK_TIMER_WHEEL_BITS * TASK_TIMER_WHEEL_LEVELS)))
+		{
+			slotTick = m_TimerTicks;
+		}
+
+	#endif
+
+	slot = (slotTick >> (TASK_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+
+	//Link in and mark the slot as occupied
+	node->slot = (level << 4) | slot;
+	_TimerLink(&m_TimerWheel[level][slot], node);
+	m_TimerWheelOccupied[level] |= (1 << slot);
+}
+
+
+
+/**
+* \brief Returns the distance from the passed slot to the next occupied slot after it, wrapping around to the slot itself
+* \param occupied The occupied bitmap of the level
+* \param slot The slot to start after
+*/
+static inline uint8_t _TimerNextOccupied(uint16_t occupied, uint8_t slot)
+{
+	uint8_t distance = 1;
+
+	//Rotate so the slot after ours is at bit 0
+	occupied = (uint16_t)((((uint32_t)occupied << TIMER_WHEEL_SLOTS) | occupied) >> ((slot + 1) & TIMER_WHEEL_MASK)) & (uint16_t)(((uint32_t)1 << TIMER_WHEEL_SLOTS) - 1);
+
+	#if TIMER_WHEEL_SLOTS > 8
+		if((uint8_t)occupied == 0)
+		{
+			occupied >>= 8;
+			distance += 8;
+		}
+	#endif
+
+	return distance + _LowestSetBit((uint8_t)occupied);
+}
+
+#endif
+
+
+
+/**
+* \brief Arms the timer to expire at the passed deadline, replacing any deadline it already had. Interrupts must be off.
+* \param node The timer to arm
+* \param deadline The scheduler tick to expire at
+*/
+void _TimerInsert(TaskTimerNode_t *node, TaskTick_t deadline)
+{
+	//Make sure we're only armed once
+	_TimerRemove(node);
+
+	node->deadline = deadline;
+
+	#if TASK_TIMER_WHEEL_BITS > 0
+
+		//Place in the wheel, no sooner than the next tick
+		_TimerPlace(node, m_TimerTicks + 1);
+
+	#else
+
+		TaskTimerNode_t **link = &m_TimerQueueHead;
+
+		//Walk past everyone expiring at or before us
+		while(*link != 0 && (int32_t)((*link)->deadline - deadline) <= 0)
+		{
+			link = &(*link)->next;
+		}
+
+		_TimerLink(link, node);
+
+	#endif
+
+	//Our deadline may come before a stretched tickless interval ends
+	_TicklessWake();
+}
+
+
+
+/**
+* \brief Disarms the timer if it is armed. Interrupts must be off.
+* \param node The timer to disarm
+*/
+void _TimerRemove(TaskTimerNode_t *node)
+{
+	//If we're not armed, nothing to do
+	if(node->link == 0)
+	{
+		return;
+	}
+
+	//Unlink
+	*node->link = node->next;
+
+	if(node->next != 0)
+	{
+		node->next->link = node->link;
+	}
+
+	#if TASK_TIMER_WHEEL_BITS > 0
+
+		//If our slot is now empty, clear it
+		if(m_TimerWheel[node->slot >> 4][node->slot & 0x0f] == 0)
+		{
+			m_TimerWheelOccupied[node->slot >> 4] &= ~(1 << (node->slot & 0x0f));
+		}
+
+	#endif
+
+	node->next = 0;
+	node->link = 0;
+}
+
+
+
+/**
+* \brief Returns true if the timer is armed
+* \param node The timer to check
+*/
+bool _TimerIsArmed(TaskTimerNode_t *node)
+{
+	return node->link != 0;
+}
+
+
+
+/**
+* \brief Moves the tick count forward and expires every timer that has come due. Interrupts must be off.
+* \param elapsed The amount of ticks that passed since the last service
+*/
+void _TimerService(uint16_t elapsed)
+{
+	TaskTimerNode_t *node;
+
+	#if TASK_TIMER_WHEEL_BITS > 0
+
+		//For every tick that passed...
+		while(elapsed-- > 0)
+		{
+			m_TimerTicks++;
+
+			//Cascade each level whose lower levels just turned over, placing its timers again from here
+			for(uint8_t level = 1; level < TASK_TIMER_WHEEL_LEVELS; level++)
+			{
+				const uint8_t slot = (m_TimerTicks >> (TASK_TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+
+				if((m_TimerTicks & (((TaskTick_t)1 << (TASK_TIMER_WHEEL_BITS * level)) - 1)) != 0)
+				{
+					break;
+				}
+
+				//Take the whole slot and place everyone again
+				node = m_TimerWheel[level][slot];
+				m_TimerWheel[level][slot] = 0;
+				m_TimerWheelOccupied[level] &= ~(1 << slot);
+
+				while(node != 0)
+				{
+					TaskTimerNode_t *next = node->next;
+					_TimerPlace(node, m_TimerTicks);
+					node = next;
+				}
+			}
+
+			//Take our slot on the bottom level
+			const uint8_t slot = m_TimerTicks & TIMER_WHEEL_MASK;
+			node = m_TimerWheel[0][slot];
+			m_TimerWheel[0][slot] = 0;
+			m_TimerWheelOccupied[0] &= ~(1 << slot);
+
+			//Expire everyone in it. The callbacks are free to arm the timer again
+			while(node != 0)
+			{
+				TaskTimerNode_t *next = node->next;
+
+				node->next = 0;
+				node->link = 0;
+
+				//If we're due, expire, else we were parked and need placing again
+				if((int32_t)(node->deadline - m_TimerTicks) <= 0)
+				{
+					node->expired(node);
+				}
+				else
+				{
+					_TimerPlace(node, m_TimerTicks + 1);
+				}
+
+				node = next;
+			}
+		}
+
+	#else
+
+		//Make up every tick that passed
+		m_TimerTicks += elapsed;
+
+		//While the front of the queue is due, pop and expire it
+		while(m_TimerQueueHead != 0 && (int32_t)(m_TimerQueueHead->deadline - m_TimerTicks) <= 0)
+		{
+			node = m_TimerQueueHead;
+			_TimerRemove(node);
+			node->expired(node);
+		}
+
+	#endif
+}
+
+
+
+/**
+* \brief Returns how many ticks until the next timer could expire, capped at the passed limit. Interrupts must be off.
+* \param limit The most ticks to return
+*/
+uint16_t _TimerTicksUntilNext(uint16_t limit)
+{
+	uint32_t ticks = limit;
+
+	#if TASK_TIMER_WHEEL_BITS > 0
+
+		//For each level with timers, find when its next occupied slot comes up
+		for(uint8_t level = 0; level < TASK_TIMER_WHEEL_LEVELS; level++)
+		{
+			if(m_TimerWheelOccupied[level] != 0)
+			{
+				const uint8_t shift = TASK_TIMER_WHEEL_BITS * level;
+				const uint8_t distance = _TimerNextOccupied(m_TimerWheelOccupied[level], (m_TimerTicks >> shift) & TIMER_WHEEL_MASK);
+
+				//The slot comes up once our lower levels turn over that many times
+				const uint32_t levelTicks = ((((m_TimerTicks >> shift) + distance) << shift) - m_TimerTicks);
+
+				if(levelTicks < ticks)
+				{
+					ticks = levelTicks;
+				}
+			}
+		}
+
+	#else
+
+		//If anyone is waiting, use the front of the queue
+		if(m_TimerQueueHead != 0)
+		{
+			const int32_t headTicks = (int32_t)(m_TimerQueueHead->deadline - m_TimerTicks);
+
+			if(headTicks < (int32_t)ticks)
+			{
+				ticks = (headTicks > 0) ? (uint32_t)headTicks : 0;
+			}
+		}
+
+	#endif
+
+	//Always wait at least one tick
+	return (ticks < 1) ? 1 : (uint16_t)ticks;
+}
+
+
+
+/**
+* \brief Returns the amount of scheduler ticks since the scheduler was first started, counting the slices of a stretched tickless \n
+* interval that have already passed, so deadlines are taken from now. Interrupts must be off.
+*/
+TaskTick_t _TimerTicks(void)
+{
+	return m_TimerTicks + _TicklessElapsedSlices();
+}
+
+
+
+/**
+* \brief Returns the amount of scheduler ticks since the scheduler was first started
+*/
+TaskTick_t GetSchedulerTicks()
+{
+	TaskTick_t ticks;
+
+	TASK_CRITICAL_SECTION ( ticks = _TimerTicks(); );
+
+	return ticks;
+}
+
+
+
+/**
+* \brief Takes the software timer out of the daemon's queue if it is waiting there. Interrupts must be off.
+* \param timer The software timer
+*/
+static void _SoftTimerUnpend(TaskSoftTimer_t *timer)
+{
+	TaskSoftTimer_t **link = &m_SoftTimerPendingHead;
+	TaskSoftTimer_t *previous = 0;
+	
+	if(!timer->pending)
+	{
+		return;
+	}
+	
+	//Find the link pointing at us and unlink
+	while(*link != 0)
+	{
+		if(*link == timer)
+		{
+			*link = timer->pendingNext;
+			
+			if(m_SoftTimerPendingTail == timer)
+			{
+				m_SoftTimerPendingTail = previous;
+			}
+			
+			break;
+		}
+		
+		previous = *link;
+		link = &(*link)->pendingNext;
+	}
+	
+	timer->pending = false;
+	timer->pendingNext = 0;
+}
+
+
+
+/**
+* \brief Called by the scheduler when a software timer expires. Queues it for the daemon and starts it again if it reloads. Interrupts must be off.
+* \param node The timer node of the software timer
+*/
+static void _SoftTimerExpired(TaskTimerNode_t *node)
+{
+	TaskSoftTimer_t *timer = (TaskSoftTimer_t *)node;
+	
+	//If we reload, start again from when we were due so the period does not drift
+	if(timer->autoReload && timer->period > 0)
+	{
+		_TimerInsert(node, node->deadline + timer->period);
+	}
+	
+	//If we're still waiting on the daemon from last time, our expiries are merged into one call
+	if(timer->pending)
+	{
+		return;
+	}
+	
+	//Queue at the back and wake the daemon
+	timer->pending = true;
+	timer->pendingNext = 0;
+	
+	if(m_SoftTimerPendingTail != 0)
+	{
+		m_SoftTimerPendingTail->pendingNext = timer;
+	}
+	else
+	{
+		m_SoftTimerPendingHead = timer;
+	}
+	
+	m_SoftTimerPendingTail = timer;
+	
+	SemaphoreGiveFromISR(&m_SoftTimerReady);
+}
+
+
+
+/**
+* \brief The timer daemon task. Runs the callback of each expired software timer in the order they expired, blocking while there are none
+*
+*/
+static void _TimerDaemon(void)
+{
+	for(;;)
+	{
+		TaskSoftTimer_t *timer;
+		
+		SemaphoreTake(&m_SoftTimerReady);
+		
+		do
+		{
+			//Take the first waiting timer
+			TASK_CRITICAL_SECTION (
+			
+				timer = m_SoftTimerPendingHead;
+				
+				if(timer != 0)
+				{
+					m_SoftTimerPendingHead = timer->pendingNext;
+					
+					if(m_SoftTimerPendingHead == 0)
+					{
+						m_SoftTimerPendingTail = 0;
+					}
+					
+					timer->pending = false;
+					timer->pendingNext = 0;
+				}
+			);
+			
+			//Run its callback with interrupts on
+			if(timer != 0)
+			{
+				timer->callback(timer->arg);
+			}
+			
+		} while(timer != 0);
+	}
+}
+
+
+
+/**
+* \brief Attaches the timer daemon task, which runs the callbacks of the software timers
+* \param id The position to attach at as well as the tasks ID
+* \param priority The priority to run callbacks at
+* \param stackSize The bytes the daemon's stack needs, enough for the deepest callback
+* \return The next id/index position, the same id if the stack doesn't fit
+*/
+TaskIndiceType_t AttachTimerDaemon(TaskIndiceType_t id, TaskPriorityLevel_t priority, uint16_t stackSize)
+{
+	const TaskIndiceType_t next = AttachTaskStack((void *)_TimerDaemon, id, stackSize);
+	
+	//If we attached, set our priority
+	if(next > id)
+	{
+		SetTaskPriority(id, priority);
+	}
+	
+	return next;
+}
+
+
+
+/**
+* \brief Initializes the software timer as stopped
+* \param timer The software timer
+* \param callback Run by the timer daemon task each time the timer expires
+* \param arg What to pass the callback
+* \param period The ticks from starting to expiring, and between expiries if reloading
+* \param autoReload true to start again from each expiry, false to stop after one
+*/
+void SoftTimerInit(TaskSoftTimer_t *timer, void (*callback)(void *arg), void *arg, TaskTimeout_t period, bool autoReload)
+{
+	TASK_CRITICAL_SECTION (
+		timer->node.next = 0;
+		timer->node.link = 0;
+		timer->node.expired = _SoftTimerExpired;
+		timer->callback = callback;
+		timer->arg = arg;
+		timer->period = period;
+		timer->autoReload = autoReload;
+		timer->pending = false;
+		timer->pendingNext = 0;
+	);
+}
+
+
+
+/**
+* \brief Starts the software timer to expire a period from now, starting it over if already running
+* \param timer The software timer
+*/
+void SoftTimerStart(TaskSoftTimer_t *timer)
+{
+	TASK_CRITICAL_SECTION (
+		_SoftTimerUnpend(timer);
+		_TimerInsert(&timer->node, _TimerTicks() + ((timer->period > 0) ? timer->period : 1));
+	);
+}
+
+
+
+/**
+* \brief Stops the software timer. If it expired and its callback hasn't run yet, it won't
+* \param timer The software timer
+*/
+void SoftTimerStop(TaskSoftTimer_t *timer)
+{
+	TASK_CRITICAL_SECTION (
+		_TimerRemove(&timer->node);
+		_SoftTimerUnpend(timer);
+	);
+}
+
+
+
+/**
+* \brief Starts the software timer over, to expire a period from now
+* \param timer The software timer
+*/
+void SoftTimerReset(TaskSoftTimer_t *timer)
+{
+	SoftTimerStart(timer);
+}
+
+
+
+/**
+* \brief Changes the period of the software timer, starting it over with the new one if it is running
+* \param timer The software timer
+* \param period The ticks from starting to expiring, and between expiries if reloading
+*/
+void SoftTimerChangePeriod(TaskSoftTimer_t *timer, TaskTimeout_t period)
+{
+	TASK_CRITICAL_SECTION (
+	
+		timer->period = period;
+		
+		if(_TimerIsArmed(&timer->node))
+		{
+			_TimerInsert(&timer->node, _TimerTicks() + ((period > 0) ? period : 1));
+		}
+	);
+}
+
+
+
+/**
+* \brief Returns true if the software timer is running
+* \param timer The software timer
+*/
+bool SoftTimerIsActive(TaskSoftTimer_t *timer)
+{
+	bool active;
+	
+	TASK_CRITICAL_SECTION ( active = _TimerIsArmed(&timer->node); );
+	
+	return active;
+}
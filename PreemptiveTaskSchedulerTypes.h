@@ -39,9 +39,28 @@ typedef uint16_t TaskMemoryLocationType_t;
 ///Data type for timeouts
 typedef int16_t TaskTimeout_t;
 
+///Data type for the scheduler tick count
+typedef uint32_t TaskTick_t;
+
 ///Data type for priority level. Highest value comes first.
 typedef int16_t TaskPriorityLevel_t;
 
+///Data type for task bitmaps, one bit per task control slot
+#if MAX_TASKS < 8
+typedef uint8_t TaskMask_t;
+#elif MAX_TASKS < 16
+typedef uint16_t TaskMask_t;
+#else
+typedef uint32_t TaskMask_t;
+#endif
+
+///Data type for the flag bits of event groups
+#if TASK_EVENT_BITS == 8
+typedef uint8_t TaskEventBits_t;
+#else
+typedef uint16_t TaskEventBits_t;
+#endif
+
 
 //TASK_SCHEDULE_LRT, //Lowest remaining time, didn't make work well ): 
 
@@ -58,11 +77,28 @@ typedef enum TaskSchedule_t
 	///Prioritizes tasks marked with the status 'main' and runs them ever other interrupt
 	TASK_SCHEDULE_PRIORITY_MAIN = 3,
 	
-	///physically reorders the task collection based on priorities
+	///Runs the tasks in an order sorted by priority, sorting again each time around
 	TASK_SCHEDULE_PRIORITY_REORDER = 4,
 	
 	///Runs based on the next highest priority out of the priorities that have not been run yet but only if the task is set as READY or is tagged as the MAIN task
-	TASK_SCHEDULE_PRIORITY_AND_READY = 5
+	TASK_SCHEDULE_PRIORITY_AND_READY = 5,
+	
+	#if TASK_DEADLINES
+	
+	///Earliest deadline first. Runs the task with the nearest absolute deadline, taking turns between tasks without deadlines when none are ready
+	TASK_SCHEDULE_EDF = 6,
+	
+	///Rate monotonic. Runs the periodic task with the highest priority, which StartTasks gives the shortest periods. Other tasks take turns when no periodic task is ready
+	TASK_SCHEDULE_RATE_MONOTONIC = 7,
+	
+	#endif
+	
+	#if TASK_STRIDE_SCHEDULING
+	
+	///Stride scheduling. Each task gets the processor in proportion to its weight, running the task with the lowest pass and moving its pass on by its stride
+	TASK_SCHEDULE_STRIDE = 8
+	
+	#endif
 	
 }
 /**
@@ -72,7 +108,7 @@ TaskSchedule_t;
 
 
 
-typedef enum TaskStatus_t
+typedef enum __attribute__ ((packed)) TaskStatus_t
 {
 	TASK_NONE = 0,
 	TASK_READY = 1,
@@ -86,13 +122,44 @@ typedef enum TaskStatus_t
 }
 /**
 *
-* \brief enum for the status of our tasks
+* \brief enum for the status of our tasks. Packed to a single byte
 *
 */
 TaskStatus_t;
 
 
 
+typedef enum TaskWaitOrder_t
+{
+	TASK_WAIT_PRIORITY = 0, //Highest priority first, first come first served among equals
+	TASK_WAIT_FIFO = 1 //First come first served
+	
+}
+/**
+*
+* \brief enum for the order tasks are woken from a wait list in
+*
+*/
+TaskWaitOrder_t;
+
+
+
+typedef enum TaskWaitState_t
+{
+	TASK_WAIT_UNTIMED = 0, //Waiting until woken, or not waiting
+	TASK_WAIT_TIMED = 1, //Our timer is the timeout of the wait we're blocked in
+	TASK_WAIT_EXPIRED = 2 //Our wait timed out before we were woken
+	
+}
+/**
+*
+* \brief enum for the timeout of the wait a task is blocked in
+*
+*/
+TaskWaitState_t;
+
+
+
 typedef union VptrSplit_t
 {
 	struct
@@ -118,6 +185,21 @@ VptrSplit_t;
 
 
 
+#if TASK_CONTEXT_ON_STACK
+
+typedef struct TaskContext_t
+{
+	//The stack pointer, the rest of the context is pushed on the stack under it
+	VptrSplit_t sp;
+	
+} 
+/**
+ * \brief Structure for holding program context data
+ */
+TaskContext_t;
+
+#else
+
 typedef struct TaskContext_t
 {
 	//The status register value
@@ -139,6 +221,212 @@ typedef struct TaskContext_t
  */
 TaskContext_t;
 
+#endif
+
+
+
+typedef struct TaskTimerNode_t
+{
+	//The next timer in our list
+	struct TaskTimerNode_t *next;
+	
+	//The pointer that points at us, 0 when not armed
+	struct TaskTimerNode_t **link;
+	
+	//The scheduler tick to expire at
+	TaskTick_t deadline;
+	
+	//Called from the scheduler interrupt when we expire
+	void (*expired)(struct TaskTimerNode_t *node);
+	
+	//The wheel level and slot we're in
+	uint8_t slot;
+	
+} 
+/**
+ * \brief Structure for timers kept by the scheduler, such as task timeouts
+ */
+TaskTimerNode_t;
+
+
+
+typedef struct TaskSoftTimer_t
+{
+	//Our place in the scheduler's timers, first so the scheduler's timer is us
+	TaskTimerNode_t node;
+	
+	//Run by the timer daemon task each time we expire
+	void (*callback)(void *arg);
+	
+	//What to pass our callback
+	void *arg;
+	
+	//The ticks from starting to expiring, and between expiries if we reload
+	TaskTimeout_t period;
+	
+	//If we start again from each expiry instead of stopping
+	bool autoReload;
+	
+	//If we expired and are waiting on the daemon to run our callback
+	bool pending;
+	
+	//The next timer waiting on the daemon
+	struct TaskSoftTimer_t *pendingNext;
+	
+} 
+/**
+ * \brief Structure for software timers, whose callbacks share the timer daemon task instead of each needing a task
+ */
+TaskSoftTimer_t;
+
+
+
+typedef struct TaskTableEntry_t
+{
+	//The function the task runs
+	void *func;
+	
+	//The bytes in the task's stack
+	uint16_t stackSize;
+	
+	//The priority level, given by the period instead for periodic tasks
+	TaskPriorityLevel_t priority;
+	
+	//The ticks between releases, 0 if not periodic
+	TaskTimeout_t period;
+	
+	//The worst case ticks each job runs for, if periodic
+	TaskTimeout_t wcet;
+	
+}
+/**
+ * \brief Structure for one task of a task table declared at compile time, see PreemptiveTaskSchedulerTable.h
+ */
+TaskTableEntry_t;
+
+
+
+typedef struct TaskMutex_t
+{
+	//The ID of the task holding us, -1 if free
+	TaskIndiceType_t owner;
+	
+	//How many times our owner has locked us
+	uint8_t count;
+	
+	//The first task waiting on us, highest priority first, -1 if none
+	TaskIndiceType_t waitHead;
+	
+	//The next mutex our owner holds
+	struct TaskMutex_t *nextHeld;
+	
+} 
+/**
+ * \brief Structure for mutexes that track their owner and lend it the priority of their waiters
+ */
+TaskMutex_t;
+
+
+
+typedef struct TaskSemaphore_t
+{
+	//How many takes we have available
+	SemaphoreValueType_t count;
+	
+	//The most our count can be given up to
+	SemaphoreValueType_t limit;
+	
+	//The first task waiting on us, -1 if none
+	TaskIndiceType_t waitHead;
+	
+	//The order our waiters are woken in
+	TaskWaitOrder_t order;
+	
+} 
+/**
+ * \brief Structure for counting semaphores that block their waiters until given
+ */
+TaskSemaphore_t;
+
+
+
+typedef struct TaskQueue_t
+{
+	//Storage for our slots, capacity times the item size
+	uint8_t *buffer;
+	
+	//The bytes in each message
+	uint8_t itemSize;
+	
+	//How many messages we hold at most
+	uint8_t capacity;
+	
+	//How many messages we hold
+	uint8_t count;
+	
+	//The slot of the oldest message
+	uint8_t front;
+	
+	//The first task waiting to send, highest priority first, -1 if none
+	TaskIndiceType_t sendHead;
+	
+	//The first task waiting to receive, highest priority first, -1 if none
+	TaskIndiceType_t receiveHead;
+	
+} 
+/**
+ * \brief Structure for message queues of fixed size slots that block their senders when full and receivers when empty
+ */
+TaskQueue_t;
+
+
+
+typedef struct TaskPool_t
+{
+	//The first free block, 0 if none
+	void *freeList;
+	
+	//Counts the free blocks, blocking allocations when there are none
+	TaskSemaphore_t available;
+	
+} 
+/**
+ * \brief Structure for pools of fixed size buffers, for passing messages by pointer through a queue
+ */
+TaskPool_t;
+
+
+
+typedef struct TaskDeferredWork_t
+{
+	//The function to run
+	void (*func)(void *arg);
+	
+	//What to pass it
+	void *arg;
+	
+} 
+/**
+ * \brief Structure for work left by an interrupt for the deferred worker task to run
+ */
+TaskDeferredWork_t;
+
+
+
+typedef struct TaskEventGroup_t
+{
+	//Our flag bits
+	TaskEventBits_t bits;
+	
+	//The first task waiting on our bits, highest priority first, -1 if none
+	TaskIndiceType_t waitHead;
+	
+} 
+/**
+ * \brief Structure for groups of event flags that tasks can block on any or all of
+ */
+TaskEventGroup_t;
+
 
 
 typedef struct TaskControl_t
@@ -147,32 +435,114 @@ typedef struct TaskControl_t
 	//Context for execution
 	TaskContext_t taskExecutionContext;
 	
-	//The status of our task
-	TaskStatus_t taskStatus;
-
+	//If we were last switched out by a yield, so only the registers a call has to keep were saved
+	bool contextPartial;
+	
 	//Our tasks data
 	void* taskData;
 
 	//Void pointer to our tasks function
 	void* task_func;
 	
-	//Current set timeout
-	TaskTimeout_t timeout;
-	
 	//The ID of this task
 	TaskIndiceType_t taskID;
 	
 	//Allocated space
 	void *_taskStack;
 	
+	//The lowest address of our stack
+	uint8_t *stackBottom;
+	
+	//The bytes in our stack
+	uint16_t stackSize;
+	
 	//The default timeout value. How long or if any timeout should exist when finishing a count.
 	TaskTimeout_t defaultTimeout;
 	
-	//Task priority level, if setting enabled
-	TaskPriorityLevel_t priority;
-	
 	//Saved priority level
 	TaskPriorityLevel_t cachedPriority;
+	
+	//Timer for yields, timeouts and default timeout reloads
+	TaskTimerNode_t wakeTimer;
+	
+	//The deadline of the default timeout reload a timed wait took our timer from
+	TaskTick_t reloadDeadline;
+	
+	//If a timed wait took our timer from a default timeout reload, which is put back after
+	bool reloadHeld;
+	
+	#if TASK_DEADLINES
+	
+	//The ticks between releases, 0 if not periodic
+	TaskTimeout_t period;
+	
+	//The ticks after each release the job is due by, 0 if no deadline
+	TaskTimeout_t relativeDeadline;
+	
+	//The tick the current job was released at
+	TaskTick_t release;
+	
+	//The tick the current job is due by
+	TaskTick_t absoluteDeadline;
+	
+	//The next task in the deadline ordered ready list
+	TaskIndiceType_t deadlineNext;
+	
+	//The amount of jobs that finished after their deadline
+	uint16_t deadlineMisses;
+	
+	//The worst case ticks each job runs for, 0 if not a periodic task
+	TaskTimeout_t wcet;
+	
+	#endif
+	
+	#if TASK_STRIDE_SCHEDULING
+	
+	//How far our pass moves each time we're picked under stride scheduling, TASK_STRIDE_ONE over our weight
+	uint16_t stride;
+	
+	//Our virtual time under stride scheduling, the lowest goes next
+	uint16_t pass;
+	
+	#endif
+	
+	//The next task in the wait list we're blocked in
+	TaskIndiceType_t waitNext;
+	
+	//The head of the wait list we're blocked in, 0 if not waiting
+	TaskIndiceType_t *waitList;
+	
+	//The mutex we're waiting on, 0 if none
+	struct TaskMutex_t *blockedOn;
+	
+	//The first of the mutexes we hold
+	struct TaskMutex_t *heldMutexes;
+	
+	//If the wait we're blocked in has a timeout, and if it ran out
+	TaskWaitState_t waitState;
+	
+	#if TASK_EVENT_GROUPS
+	
+	//The event bits we're waiting on, then once woken, the bits that woke us
+	TaskEventBits_t eventBits;
+	
+	//How we're waiting on our event bits, TASK_EVENT_WAIT_ALL and TASK_EVENT_CLEAR_ON_EXIT
+	uint8_t eventOptions;
+	
+	#endif
+	
+	#if TASK_JOIN
+	
+	//The head of the wait list of tasks joined on us, -1 if none
+	TaskIndiceType_t joinHead;
+	
+	//The value we exit with
+	uint8_t exitValue;
+	
+	//The value the task we last joined exited with, set as we're woken
+	uint8_t joinedValue;
+	
+	#endif
 }
 
 /**